@@ -0,0 +1,293 @@
+// Microbenchmarks for the rename engine hot paths. Synthetic directories of
+// scene-style filenames are made on tmpfs (/dev/shm when there is one) and
+// each function is timed on its own. Results are written as JSON.
+//
+// renamec_bench [--sizes 1000,10000,100000] [--out bench.json] [--dir DIR]
+
+#include "colors.h"
+#include "history.h"
+#include "pattern.h"
+#include "rnFunctions.h"
+#include "snapshot.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    struct Result
+    {
+        std::string name{};
+        std::size_t files{};
+        std::size_t iterations{};
+        double minSeconds{};
+        double meanSeconds{};
+    };
+
+    // Deterministic names like Show.Name.S01E05.720p.WEB-DL.x264-GROUP.mkv
+    std::vector<std::string> sceneNames(std::size_t count)
+    {
+        static const std::array<const char*, 10> titles{
+            "The.Expanse", "Dark", "Better.Call.Saul", "Blade.Runner", "The.Office",
+            "Arrival", "Severance", "Chernobyl", "Mad.Max.Fury.Road", "Fargo"};
+        static const std::array<const char*, 4> resolutions{"480p", "720p", "1080p", "2160p"};
+        static const std::array<const char*, 4> sources{"WEB-DL", "BluRay", "HDTV", "WEBRip"};
+        static const std::array<const char*, 3> codecs{"x264", "x265", "H.264"};
+        static const std::array<const char*, 5> groups{"NTb", "FLUX", "SPARKS", "GalaxyTV", "RARBG"};
+        static const std::array<const char*, 4> extensions{".mkv", ".mp4", ".srt", ".nfo"};
+
+        std::mt19937 random{20240101};
+        auto pick = [&random](const auto& list) { return list[random() % list.size()]; };
+
+        std::vector<std::string> names{};
+        names.reserve(count);
+        for (std::size_t idx{}; idx < count; ++idx)
+        {
+            std::string name{pick(titles)};
+            char numbers[32]{};
+            if (random() % 4)
+                std::snprintf(numbers, sizeof(numbers), ".S%02uE%02u.",
+                              static_cast<unsigned>(1 + random() % 12), static_cast<unsigned>(1 + random() % 24));
+            else
+                std::snprintf(numbers, sizeof(numbers), ".%u.", static_cast<unsigned>(1970 + random() % 55));
+            name += numbers;
+            name += std::string{pick(resolutions)} + '.' + pick(sources) + '.' + pick(codecs) + '-' + pick(groups);
+            name += "." + std::to_string(idx) + pick(extensions);    // Keeps names unique
+            names.push_back(std::move(name));
+        }
+        return names;
+    }
+
+    // Run task until it has had a quarter second (at least minRuns times)
+    Result measure(const std::string& name, std::size_t files, const std::function<void()>& task,
+                   std::size_t minRuns = 3)
+    {
+        using Clock = std::chrono::steady_clock;
+        Result result{name, files};
+        double total{};
+        while (result.iterations < minRuns || (total < 0.25 && result.iterations < 1000))
+        {
+            auto start{Clock::now()};
+            task();
+            double seconds{std::chrono::duration<double>(Clock::now() - start).count()};
+            result.minSeconds = result.iterations ? std::min(result.minSeconds, seconds) : seconds;
+            total += seconds;
+            ++result.iterations;
+        }
+        result.meanSeconds = total / result.iterations;
+        std::cerr << "  " << name << ": " << result.minSeconds * 1e3 << " ms\n";
+        return result;
+    }
+
+    std::string jsonString(const std::string& text)
+    {
+        std::string quoted{"\""};
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                quoted += '\\';
+            quoted += c;
+        }
+        return quoted + '"';
+    }
+
+    void writeJson(std::ostream& out, const std::vector<Result>& results)
+    {
+        out << "{\n  \"benchmarks\": [";
+        for (std::size_t idx{}; idx < results.size(); ++idx)
+        {
+            const Result& result{results[idx]};
+            out << (idx ? ",\n" : "\n") << "    {\"name\": " << jsonString(result.name)
+                << ", \"files\": " << result.files
+                << ", \"iterations\": " << result.iterations
+                << ", \"min_ms\": " << result.minSeconds * 1e3
+                << ", \"mean_ms\": " << result.meanSeconds * 1e3
+                << ", \"ns_per_file\": " << (result.files ? result.minSeconds * 1e9 / result.files : 0.0)
+                << '}';
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    void benchSize(std::size_t count, const fs::path& base, std::vector<Result>& results)
+    {
+        std::cerr << count << " files\n";
+        const fs::path dir{base / ("files-" + std::to_string(count))};
+        fs::create_directories(dir);
+        const std::vector<std::string> names{sceneNames(count)};
+        for (auto& name : names)
+            std::ofstream{dir / name};
+
+        const fs::path programName{base / ("renamec-" + std::to_string(count))};
+        Filenames files{};
+        results.push_back(measure("getFilenames", count, [&]
+        {
+            files = getFilenames({dir}, programName);
+        }));
+
+        std::vector<FileRecord> records{};
+        records.reserve(files.size());
+        for (auto pair : files)
+            records.push_back(pair.second);
+
+        std::size_t found{};
+        for (const char* pattern : {"720p", "s0?e0?", "720p*web"})
+        {
+            std::string shape{pattern};
+            results.push_back(measure("checkPatternWithRegex/" + shape, count, [&]
+            {
+                for (auto& record : records)
+                    found += checkPatternWithRegex(record.lowerName, shape);
+            }));
+        }
+
+        // A compiled pattern, as keywordDefaultReplace matches the menu
+        for (const char* pattern : {"720p", "s0?e0?", "720p*web", "#index 4"})
+        {
+            std::string shape{pattern};
+            const Pattern compiled{shape};
+            const std::int16_t index{getIndex(shape)};
+            results.push_back(measure("patternMatches/" + shape, count, [&]
+            {
+                for (auto& record : records)
+                    found += patternMatches(record, shape, compiled, index);
+            }));
+        }
+
+        results.push_back(measure("strReplaceAll", count, [&]
+        {
+            for (auto& record : records)
+                found += strReplaceAll(record.filename, ".", " ").size();
+        }));
+
+        for (const char* lpat : {"s0?e", "720p", "#index 4"})
+        {
+            std::string shape{lpat};
+            results.push_back(measure("getBetweenFilename/" + shape, count, [&]
+            {
+                for (auto& record : records)
+                    found += getBetweenFilename(record, shape, "-", "[x]", false).native().size();
+            }));
+        }
+
+        // Every file renamed and back again (two batches, both saved to history)
+        {
+            HistoryData history{programName};
+            DirectorySnapshot snapshot{programName};
+            snapshot.reload({dir});
+            Filenames menu{snapshot.files};
+            results.push_back(measure("renameAndMenuUpdate", count * 2, [&]
+            {
+                for (bool back : {false, true})
+                {
+                    Filenames newPaths{};
+                    for (auto pair : menu)
+                    {
+                        std::string path{pair.second.path.string()};
+                        path = back ? path.substr(0, path.size() - 2) : path + ".b";
+                        newPaths[pair.first] = pair.second.renamed(path);
+                    }
+                    renameAndMenuUpdate(newPaths, menu, history, snapshot);
+                    snapshot.update();
+                }
+            }, 1));
+        }
+
+        // History log: append one entry for every file, then reopen and read it
+        {
+            HistoryLog::OldNewFiles entry{};
+            for (auto& record : records)
+                entry[record.path] = record.path.string() + ".b";
+            const fs::path historyProgram{base / ("history-" + std::to_string(count)) / "renamec"};
+            fs::create_directories(historyProgram.parent_path());
+            {
+                HistoryData history{historyProgram};
+                results.push_back(measure("HistoryData::add", count, [&]
+                {
+                    history.add(entry);
+                }));
+            }
+            results.push_back(measure("HistoryData::load", count, [&]
+            {
+                HistoryData history{historyProgram};
+                found += history.entry(0).size();
+            }));
+        }
+
+        if (!found)
+            std::cerr << "  (nothing matched)\n";
+        fs::remove_all(dir);
+    }
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::size_t> sizes{1000, 10000, 100000};
+    fs::path out{"bench.json"};
+    std::error_code ec{};
+    fs::path base{fs::is_directory("/dev/shm", ec) ? fs::path{"/dev/shm"} : fs::temp_directory_path()};
+
+    for (int idx{1}; idx < argc; ++idx)
+    {
+        std::string arg{argv[idx]};
+        if (arg == "--sizes" && idx + 1 < argc)
+        {
+            sizes.clear();
+            std::stringstream list{argv[++idx]};
+            std::string size{};
+            while (std::getline(list, size, ','))
+                sizes.push_back(std::stoul(size));
+        }
+        else if (arg == "--out" && idx + 1 < argc)
+            out = argv[++idx];
+        else if (arg == "--dir" && idx + 1 < argc)
+            base = argv[++idx];
+        else
+        {
+            std::cerr << "Usage: renamec_bench [--sizes 1000,10000,100000,1000000] [--out FILE] [--dir DIR]\n";
+            return 2;
+        }
+    }
+
+    setColorEnabled(false);
+    batchMode.active = true;    // No prompts
+    base /= "renamec-bench-" + std::to_string(std::random_device{}());
+    std::vector<Result> results{};
+    try
+    {
+        fs::create_directories(base);
+        for (std::size_t size : sizes)
+            benchSize(size, base, results);
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        fs::remove_all(base, ec);
+        return 1;
+    }
+    fs::remove_all(base, ec);
+    if (batchMode.failed)
+        std::cerr << batchMode.failed << " renames failed.\n";
+
+    std::ofstream file{out};
+    writeJson(file, results);
+    std::cerr << "Results written to " << out.string() << '\n';
+    return 0;
+}
@@ -0,0 +1,248 @@
+#ifndef CHAIN_H
+#define CHAIN_H
+
+#include "filenames.h"
+#include "pattern.h"
+#include "rnFunctions.h"
+#include "stats.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+
+
+// Rename keywords joined with | ("!dots | !cap | between [ #end -> """),
+// applied to the filenames in memory. Each step works on the names left by
+// the step before it, so every file is checked and renamed once, under its
+// final name.
+//
+// Steps: !dots, !cap, !lower, PAT -> NEW, between LEFT RIGHT -> NEW and
+// between+ LEFT RIGHT -> NEW. Quotes keep spaces in a pattern ("" is empty).
+class RenameChain
+{
+    enum class Kind { dots, cap, lower, replace, between };
+
+    struct Step
+    {
+        Kind kind{};
+        std::string pattern{};
+        Pattern lpattern{};
+        Pattern rpattern{};
+        std::string replacement{};
+        std::int16_t index{};        // #index in a replace pattern
+        bool plus{};
+    };
+
+    std::vector<Step> steps{};
+
+public:
+    std::string error{};        // Set when the chain can't be read
+
+    RenameChain() = default;
+
+    explicit RenameChain(const std::string& text)
+        {
+            if (text.empty())
+                return;
+            for (const std::string& part : splitString(text, "|"))
+            {
+                if (!addStep(part))
+                {
+                    error = "Cannot read chain step: \"" + part + "\"";
+                    return;
+                }
+            }
+        }
+
+    // Input is a chain when one of its |-separated parts is a step. | is a
+    // legal filename character, so a search for it stays a search.
+    static bool isChain(const std::string& text)
+    {
+        if (text.find('|') == std::string::npos)
+            return false;
+        for (const std::string& part : splitString(text, "|"))
+        {
+            if (part == "!dots" || part == "!cap" || part == "!lower" ||
+                part.find("->") != std::string::npos)
+                return true;
+        }
+        return false;
+    }
+
+    // PAT -> NEW
+    void addReplace(const std::string& pattern, const std::string& replacement)
+    {
+        Step step{};
+        step.kind = Kind::replace;
+        step.pattern = lowercase(pattern);
+        step.lpattern = Pattern{step.pattern};
+        step.index = getIndex(step.pattern);
+        step.replacement = replacement;
+        steps.push_back(std::move(step));
+    }
+
+    // between(+) LEFT RIGHT -> NEW
+    void addBetween(const std::string& lpat, const std::string& rpat,
+                    const std::string& replacement, bool plus)
+    {
+        Step step{};
+        step.kind = Kind::between;
+        step.plus = plus;
+        step.lpattern = Pattern{lpat.empty() ? "#begin" : lpat};
+        step.rpattern = Pattern{rpat.empty() ? "#end" : rpat};
+        step.replacement = replacement;
+        steps.push_back(std::move(step));
+    }
+
+    // A step numbers its matches (#^), so it needs all of them at once
+    bool numbered() const
+    {
+        for (const Step& step : steps)
+        {
+            if (step.replacement.find("#^") != std::string::npos)
+                return true;
+        }
+        return false;
+    }
+
+    // The new record of each file (the same record if the chain leaves it alone)
+    std::vector<FileRecord> apply(std::vector<FileRecord> files) const
+    {
+        PhaseTimer timer{Phase::match, files.size() * steps.size()};
+        for (const Step& step : steps)
+        {
+            std::vector<std::uint8_t> matched(files.size());
+            std::vector<BetweenMatch> betweens(step.kind == Kind::between ? files.size() : 0);
+            parallelFor(files.size(), [&](std::size_t pos)
+            {
+                if (step.kind == Kind::between)
+                {
+                    betweens[pos] = matchBetween(files[pos], step.lpattern, step.rpattern, step.plus);
+                    matched[pos] = betweens[pos].renamable;
+                }
+                else
+                    matched[pos] = step.kind != Kind::replace ||
+                                   patternMatches(files[pos], step.pattern, step.lpattern, step.index);
+            });
+
+            // #^ numbers come from the position among the files this step matches
+            std::vector<std::size_t> number(files.size());
+            std::size_t count{};
+            for (std::size_t pos{}; pos < files.size(); ++pos)
+            {
+                if (matched[pos])
+                    number[pos] = ++count;
+            }
+
+            parallelFor(files.size(), [&](std::size_t pos)
+            {
+                if (!matched[pos])
+                    return;
+                const BetweenMatch* match{betweens.empty() ? nullptr : &betweens[pos]};
+                fs::path newPath{rename(step, files[pos], match, number[pos], count)};
+                if (!newPath.empty() && newPath != files[pos].path)
+                    files[pos] = files[pos].renamed(newPath);
+            });
+        }
+        return files;
+    }
+
+private:
+    bool addStep(const std::string& part)
+    {
+        if (part == "!dots" || part == "!cap" || part == "!lower")
+        {
+            Step step{};
+            step.kind = part == "!dots" ? Kind::dots : part == "!cap" ? Kind::cap : Kind::lower;
+            steps.push_back(std::move(step));
+            return true;
+        }
+
+        std::size_t arrow{part.find("->")};
+        if (arrow == std::string::npos)
+            return false;
+        std::string left{removeSpace(part.substr(0, arrow))};
+        std::string replacement{unquote(removeSpace(part.substr(arrow + 2)))};
+
+        std::vector<std::string> leftWords{words(left)};
+        if (!leftWords.empty() && (leftWords[0] == "between" || leftWords[0] == "between+"))
+        {
+            if (leftWords.size() != 3)
+                return false;
+            addBetween(leftWords[1], leftWords[2], replacement, leftWords[0] == "between+");
+            return true;
+        }
+        if (unquote(left).empty())
+            return false;
+        addReplace(unquote(left), replacement);
+        return true;
+    }
+
+    // New path for one file, empty if the step leaves it alone
+    static fs::path rename(const Step& step, const FileRecord& file, const BetweenMatch* match,
+                           std::size_t number, std::size_t count)
+    {
+        std::string filename{};
+        std::string replacement{step.replacement};
+        switch (step.kind)
+        {
+        case Kind::dots:
+            filename = replaceDots(file);
+            break;
+        case Kind::cap:
+            filename = file.filename;
+            capitalize(filename);
+            break;
+        case Kind::lower:
+            filename = file.lowerName;
+            break;
+        case Kind::replace:
+            if (step.lpattern.hasDigits && replacement.find("?") != std::string::npos)
+                replacement = replaceDigits(step.lpattern.digits(file.lowerName), replacement);
+            replacement = convertSequenceNumber(replacement, number, count);
+            return renameFile(file, step.lpattern.matchText(file.lowerName), replacement);
+        case Kind::between:
+            replacement = convertSequenceNumber(replacement, number, count);
+            return getBetweenFilename(*match, replacement);
+        }
+        if (filename.empty())
+            return fs::path{};
+        return file.path.parent_path() / filename;
+    }
+
+    // Words split on spaces, "quoted words" kept whole
+    static std::vector<std::string> words(const std::string& text)
+    {
+        std::vector<std::string> found{};
+        std::size_t pos{};
+        while ( (pos = text.find_first_not_of(' ', pos)) != std::string::npos )
+        {
+            std::size_t end{};
+            if (text[pos] == '"' && (end = text.find('"', pos + 1)) != std::string::npos)
+            {
+                found.push_back(text.substr(pos + 1, end - pos - 1));
+                pos = end + 1;
+                continue;
+            }
+            end = std::min(text.find(' ', pos), text.length());
+            found.push_back(text.substr(pos, end - pos));
+            pos = end;
+        }
+        return found;
+    }
+
+    static std::string unquote(const std::string& text)
+    {
+        if (text.length() >= 2 && text.front() == '"' && text.back() == '"')
+            return text.substr(1, text.length() - 2);
+        return text;
+    }
+};
+
+#endif
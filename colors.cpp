@@ -1,15 +1,152 @@
+#include "colors.h"
+#include "stats.h"
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <string_view>
+#ifdef _WIN32
 #include <windows.h>
-#include <cstdint>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef _WIN32
+    HANDLE H{GetStdHandle(STD_OUTPUT_HANDLE)};
+#endif
+    bool ansi{true};    // Escapes understood by the terminal (else Win32 attributes)
+
+    // Colour only on a terminal. Windows consoles are switched to ANSI
+    // escapes when they support them.
+    bool detectColor()
+    {
+#ifdef _WIN32
+        if (!_isatty(_fileno(stdout)))
+            return false;
+        DWORD mode{};
+        ansi = GetConsoleMode(H, &mode) &&
+               SetConsoleMode(H, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+        return true;
+#else
+        const char* term{std::getenv("TERM")};
+        return isatty(STDOUT_FILENO) && !(term && std::strcmp(term, "dumb") == 0);
+#endif
+    }
+
+    bool colorEnabled{detectColor()};
+
+    // Console attribute (blue 1, green 2, red 4, bright 8, background << 4)
+    // as an ANSI escape. 7 (default white) resets.
+    std::string makeEscape(std::int16_t color)
+    {
+        if (color == Color::default_white)
+            return "\x1b[0m";
+        auto ansiColor = [](int bits)
+        {
+            return ((bits & 1) ? 4 : 0) | (bits & 2) | ((bits & 4) ? 1 : 0);
+        };
+        int foreground{color & 0xF};
+        int background{(color >> 4) & 0xF};
+        std::string escape{"\x1b[0;"};
+        escape += std::to_string(((foreground & 8) ? 90 : 30) + ansiColor(foreground));
+        if (background)
+            escape += ';' + std::to_string(((background & 8) ? 100 : 40) + ansiColor(background));
+        return escape + 'm';
+    }
+
+    const std::array<std::string, 256> escapes{[]
+    {
+        std::array<std::string, 256> table{};
+        for (std::size_t color{}; color < table.size(); ++color)
+            table[color] = makeEscape(static_cast<std::int16_t>(color));
+        return table;
+    }()};
+
+    std::string_view escape(std::int16_t color)
+    {
+        return escapes[static_cast<std::uint8_t>(color)];
+    }
+
+    void setAttribute([[maybe_unused]] std::int16_t color)
+    {
+#ifdef _WIN32
+        SetConsoleTextAttribute(H, color);
+#endif
+    }
+}
+
+Screen screen{};
+
 
-HANDLE H{GetStdHandle(STD_OUTPUT_HANDLE)};
 
 void setColor(std::int16_t color)
 {
-    SetConsoleTextAttribute(H, color);
+    screen.flush();
+    if (!colorEnabled)
+        return;
+    if (ansi)
+        std::cout << escape(color);
+    else
+    {
+        std::cout.flush();
+        setAttribute(color);
+    }
 }
 
 void resetColor()
 {
-    SetConsoleTextAttribute(H, 7); // default white
+    setColor(Color::default_white);
+}
+
+void setColorEnabled(bool enabled)
+{
+    colorEnabled = enabled;
+}
+
+
+
+Screen& Screen::color(std::int16_t color)
+{
+    if (!colorEnabled)
+        return *this;
+    if (ansi)
+        buffer.append(escape(color));
+    else
+        attributes.emplace_back(buffer.size(), color);
+    return *this;
+}
+
+Screen& Screen::reset()
+{
+    return color(Color::default_white);
+}
+
+void Screen::flush()
+{
+    if (buffer.empty() && attributes.empty())
+        return;
+    PhaseTimer timer{Phase::preview};
+    timer.calls = 1 + attributes.size();
+    timer.bytes = buffer.size();
+
+    // The legacy console changes colour between writes
+    std::size_t written{};
+    for (auto& [pos, color] : attributes)
+    {
+        std::cout.write(buffer.data() + written, pos - written);
+        std::cout.flush();
+        setAttribute(color);
+        written = pos;
+    }
+    std::cout.write(buffer.data() + written, buffer.size() - written);
+    std::cout.flush();
+
+    buffer.clear();
+    attributes.clear();
 }
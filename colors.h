@@ -1,6 +1,12 @@
 #ifndef COLORS
 #define COLORS
+#include <cstddef>
 #include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace Color
 {
@@ -20,4 +26,48 @@ namespace Color
 void setColor(std::int16_t color);
 void resetColor();
 
-#endif
\ No newline at end of file
+// Turn console colours off (output piped to another program)
+void setColorEnabled(bool enabled);
+
+
+
+// Builds a whole screen of text and colours in one buffer, written to the
+// console with one call by flush(). Colours are ANSI escapes (or, on a
+// Windows console without them, attributes applied while flushing) and are
+// left out when output is not a terminal.
+class Screen
+{
+    std::string buffer{};
+    std::vector<std::pair<std::size_t, std::int16_t>> attributes{};  // Legacy Windows console
+
+public:
+    Screen& color(std::int16_t color);
+    Screen& reset();
+
+    Screen& operator<<(std::string_view text)
+    {
+        buffer.append(text);
+        return *this;
+    }
+
+    Screen& operator<<(char c)
+    {
+        buffer.push_back(c);
+        return *this;
+    }
+
+    template <typename Number, typename = std::enable_if_t<std::is_arithmetic_v<Number>>>
+    Screen& operator<<(Number number)
+    {
+        buffer.append(std::to_string(number));
+        return *this;
+    }
+
+    // Write everything built so far, then start a new buffer
+    void flush();
+};
+
+// Console output not yet flushed (flushed before error messages and prompts)
+extern Screen screen;
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef CONFLICTS_H
+#define CONFLICTS_H
+
+#include "snapshot.h"
+#include "stats.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+
+
+// Checks new filenames against hash sets of the names already in each
+// directory (built once from the snapshot) and the names claimed so far.
+// Directories outside the snapshot are listed once on first use.
+class ConflictChecker
+{
+#ifdef _WIN32
+    static constexpr bool foldCase{true};   // Matches fs::exists on Windows
+#else
+    static constexpr bool foldCase{false};
+#endif
+
+    std::unordered_map<std::string, std::unordered_set<std::string>> dirNames{};
+    std::unordered_set<std::string> claimed{};
+    bool allowCaseRename{};
+
+public:
+    // allowCaseRename: a name differing from the old one only by case is never a
+    // conflict (on case-insensitive systems)
+    ConflictChecker(DirectorySnapshot& snapshot, bool caseOnly = false)
+        {
+            allowCaseRename = caseOnly;
+            snapshot.update();
+            PhaseTimer timer{Phase::conflicts, snapshot.files.size()};
+            for (auto& dir : snapshot.directories)
+                dirNames[dir.string()];
+            for (const auto& pair : snapshot.files)
+                dirNames[pair.second.path.parent_path().string()].insert(fold(pair.second.filename));
+
+            // The program itself is left out of the menu but still takes up its name
+            auto programDir{dirNames.find(snapshot.programName.parent_path().string())};
+            if (programDir != dirNames.end())
+                programDir->second.insert(fold(snapshot.programName.filename().string()));
+        }
+
+    // Claims the new names of a whole batch, returning which files may be
+    // renamed. A name held by another file of the batch is free as long as
+    // that file is renamed too (chains, swaps and cycles). When two files
+    // ask for the same name the first one gets it.
+    std::vector<std::uint8_t> claimAll(const std::vector<const FileRecord*>& files,
+                                       const std::vector<fs::path>& newPaths)
+    {
+        std::size_t count{files.size()};
+        PhaseTimer timer{Phase::conflicts, count};
+        std::vector<std::uint8_t> allowed(count, 1);
+        std::unordered_map<std::string, std::size_t> sources{};
+        std::unordered_map<std::string, std::size_t> targets{};
+        for (std::size_t idx{}; idx < count; ++idx)
+            sources[key(files[idx]->path)] = idx;
+
+        std::vector<std::size_t> refused{};
+        for (std::size_t idx{}; idx < count; ++idx)
+        {
+            std::string target{key(newPaths[idx])};
+            bool taken{claimed.contains(target) || !targets.emplace(target, idx).second};
+            if (!taken && !caseRename(*files[idx], newPaths[idx]) && exists(newPaths[idx]))
+            {
+                auto owner{sources.find(target)};
+                taken = (owner == sources.end() || owner->second == idx) &&
+                        !sameEntry(files[idx]->path, newPaths[idx]);
+            }
+            if (taken)
+            {
+                allowed[idx] = 0;
+                refused.push_back(idx);
+            }
+        }
+
+        // A refused file keeps its name, so whoever wanted that name is refused too
+        while (!refused.empty())
+        {
+            std::size_t idx{refused.back()};
+            refused.pop_back();
+            auto waiting{targets.find(key(files[idx]->path))};
+            if (waiting == targets.end() || !allowed[waiting->second] ||
+                caseRename(*files[waiting->second], newPaths[waiting->second]))
+                continue;
+            allowed[waiting->second] = 0;
+            refused.push_back(waiting->second);
+        }
+
+        for (std::size_t idx{}; idx < count; ++idx)
+        {
+            if (allowed[idx])
+                claimed.insert(key(newPaths[idx]));
+        }
+        return allowed;
+    }
+
+    // Whether a name is taken on disk (from the cached listing of its directory)
+    bool exists(const fs::path& path)
+    {
+        std::string dir{path.parent_path().string()};
+        auto names{dirNames.find(dir)};
+        if (names == dirNames.end())
+        {
+            names = dirNames.emplace(dir, std::unordered_set<std::string>{}).first;
+            stats.count(Phase::conflicts, 1);
+            std::error_code ec{};
+            for (fs::directory_iterator it{path.parent_path(), ec}, end{}; !ec && it != end; it.increment(ec))
+                names->second.insert(fold(it->path().filename().string()));
+        }
+        return names->second.contains(fold(path.filename().string()));
+    }
+
+    // Forget claimed names (existing names are kept)
+    void resetClaims()
+    {
+        claimed.clear();
+    }
+
+private:
+    static std::string fold(const std::string& filename)
+    {
+        return foldCase ? lowercase(filename) : filename;
+    }
+
+    static std::string key(const fs::path& path)
+    {
+        return (path.parent_path() / fold(path.filename().string())).string();
+    }
+
+    // A name differing from the old one only by case is never a conflict
+    // where names are case-insensitive. Elsewhere it can be another file.
+    bool caseRename(const FileRecord& file, const fs::path& newPath) const
+    {
+        std::string newFilename{newPath.filename().string()};
+        return allowCaseRename && foldCase && lowercase(newFilename) == file.lowerName &&
+               newFilename != file.filename;
+    }
+
+    // The new name is the file itself (a case-insensitive mount on Linux)
+    static bool sameEntry(const fs::path& path, const fs::path& newPath)
+    {
+        if (foldCase || path.filename() == newPath.filename())
+            return false;
+        std::error_code ec{};
+        return fs::equivalent(path, newPath, ec);
+    }
+};
+
+#endif
@@ -0,0 +1,521 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#ifndef _WIN32
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+
+
+// Renames a batch of files on a pool of workers. Each parent directory is
+// opened once and names are renamed relative to it, so long paths are not
+// resolved again for every file. Workers are added while renames are slow
+// (network drives) and held back while they are fast (local disks).
+//
+// A rename whose new name is the old name of another file in the batch waits
+// for that file to move first (a->b, b->c). Cycles are broken with a
+// temporary name, and a swap of two files uses RENAME_EXCHANGE where the
+// system has it. Files are renamed before the directories holding them.
+//
+// Each level of nested renames is planned into steps before it runs, so a
+// caller can record the steps (temporary names included) and which are done.
+class RenameExecutor
+{
+public:
+    using Rename = std::pair<fs::path, fs::path>;
+
+    static constexpr std::size_t npos{static_cast<std::size_t>(-1)};
+
+    struct Step
+    {
+        fs::path from{};
+        fs::path to{};
+        std::size_t after{npos};      // Step that has to move away from "to" first
+        std::size_t first{npos};      // Step that moved the file to a temporary name
+        bool exchange{};              // Swap "from" and "to"
+        std::size_t rename{npos};     // Renames of the batch finished by this step
+        std::size_t partner{npos};
+        fs::path temp{};              // Exchange without RENAME_EXCHANGE goes through it
+    };
+
+    using StepsPlanned = std::function<void(const std::vector<Step>&)>;
+    using StepDone = std::function<void(std::size_t)>;
+
+private:
+    static constexpr std::int64_t fastRename{200'000};    // Nanoseconds
+
+    std::size_t maxWorkers{};
+#ifndef _WIN32
+    std::map<fs::path, int> dirFds{};
+#endif
+
+    // State for one call to run
+    std::vector<Step> steps{};
+    std::vector<std::error_code> stepErrors{};
+    const std::vector<std::size_t>* wave{};
+    const StepDone* stepDone{};
+    std::atomic<std::size_t> next{};
+    std::atomic<std::int64_t> averageLatency{};
+    std::atomic<std::size_t> workerLimit{1};
+    std::vector<std::thread> threads{};
+    std::mutex threadMutex{};
+    std::condition_variable limitRaised{};
+
+public:
+    RenameExecutor(std::size_t workers = 16)
+        {
+            maxWorkers = std::max<std::size_t>(workers, 1);
+        }
+
+    ~RenameExecutor()
+        {
+#ifndef _WIN32
+            for (auto& pair : dirFds)
+            {
+                if (pair.second >= 0)
+                    close(pair.second);
+            }
+#endif
+        }
+
+    RenameExecutor(const RenameExecutor&) = delete;
+    RenameExecutor& operator=(const RenameExecutor&) = delete;
+
+    // Rename every pair (old path, new path). Results are in the same order,
+    // an empty error_code for each rename that worked. onPlanned gets the
+    // steps of each level before any of them runs (renames numbered as in
+    // the batch, after/first within the level), and onStepDone is called from
+    // the workers with the index of each step in its level once it is done.
+    std::vector<std::error_code> run(const std::vector<Rename>& batch,
+                                     const StepsPlanned& onPlanned = {},
+                                     const StepDone& onStepDone = {})
+    {
+        std::vector<std::vector<std::size_t>> groups{levels(batch)};
+        if (groups.size() <= 1)
+            return runLevel(batch, onPlanned, onStepDone);
+
+        // Nested renames: one level at a time, deepest files first
+        std::vector<std::error_code> errors(batch.size());
+        for (auto& group : groups)
+        {
+            std::vector<Rename> levelBatch{};
+            for (std::size_t idx : group)
+                levelBatch.push_back(batch[idx]);
+            StepsPlanned levelPlanned{};
+            if (onPlanned)
+            {
+                levelPlanned = [&](const std::vector<Step>& levelSteps)
+                {
+                    std::vector<Step> numbered{levelSteps};
+                    for (auto& step : numbered)
+                    {
+                        for (std::size_t* index : {&step.rename, &step.partner})
+                        {
+                            if (*index != npos)
+                                *index = group[*index];
+                        }
+                    }
+                    onPlanned(numbered);
+                };
+            }
+
+            std::vector<std::error_code> levelErrors{runLevel(levelBatch, levelPlanned, onStepDone)};
+            for (std::size_t pos{}; pos < group.size(); ++pos)
+                errors[group[pos]] = levelErrors[pos];
+        }
+        return errors;
+    }
+
+private:
+    std::vector<std::error_code> runLevel(const std::vector<Rename>& batch,
+                                          const StepsPlanned& onPlanned, const StepDone& onStepDone)
+    {
+        stepDone = &onStepDone;
+        std::vector<std::size_t> resultStep{plan(batch)};
+        if (onPlanned)
+            onPlanned(steps);
+        stepErrors.assign(steps.size(), std::error_code{});
+        averageLatency = 0;
+        openDirectories();
+
+        for (auto& stepWave : waves())
+        {
+            wave = &stepWave;
+            next = 0;
+            workerLimit = 1;
+            worker(0);
+
+            // No worker is started once the calling thread has run out of steps
+            std::vector<std::thread> started{};
+            {
+                std::lock_guard<std::mutex> lock{threadMutex};
+                started.swap(threads);
+            }
+            for (auto& thread : started)
+                thread.join();
+        }
+
+        std::vector<std::error_code> errors(batch.size());
+        for (std::size_t idx{}; idx < batch.size(); ++idx)
+            errors[idx] = stepErrors[resultStep[idx]];
+
+        wave = nullptr;
+        stepDone = nullptr;
+        steps.clear();
+        stepErrors.clear();
+        return errors;
+    }
+
+    // A rename inside a directory renamed by the batch goes before it (the
+    // old path would be gone), one into a directory the batch renames back
+    // goes after it (undo). Returns the batch grouped into levels to run in
+    // order, a single level when nothing is nested.
+    static std::vector<std::vector<std::size_t>> levels(const std::vector<Rename>& batch)
+    {
+        std::size_t count{batch.size()};
+        std::unordered_map<std::string, std::size_t> fromIndex{};
+        std::unordered_map<std::string, std::size_t> toIndex{};
+        for (std::size_t idx{}; idx < count; ++idx)
+        {
+            fromIndex[batch[idx].first.generic_string()] = idx;
+            toIndex[batch[idx].second.generic_string()] = idx;
+        }
+
+        // Renames moving each parent directory (or one above it), found once per directory
+        std::unordered_map<std::string, std::vector<std::size_t>> movedAbove{};
+        std::unordered_map<std::string, std::vector<std::size_t>> movedInto{};
+        std::vector<std::vector<std::size_t>> before(count);
+        bool nested{};
+        for (std::size_t idx{}; idx < count; ++idx)
+        {
+            std::string parent{batch[idx].first.parent_path().generic_string()};
+            if (!movedAbove.contains(parent))
+            {
+                std::vector<std::size_t>& above{movedAbove[parent]};
+                std::vector<std::size_t>& into{movedInto[parent]};
+                for (fs::path dir{batch[idx].first.parent_path()}; !dir.empty(); dir = dir.parent_path())
+                {
+                    auto from{fromIndex.find(dir.generic_string())};
+                    if (from != fromIndex.end())
+                        above.push_back(from->second);
+                    auto to{toIndex.find(dir.generic_string())};
+                    if (to != toIndex.end())
+                        into.push_back(to->second);
+                    if (dir == dir.parent_path())
+                        break;
+                }
+            }
+            for (std::size_t other : movedAbove[parent])
+                before[other].push_back(idx);
+            for (std::size_t other : movedInto[parent])
+                before[idx].push_back(other);
+            nested = nested || !movedAbove[parent].empty() || !movedInto[parent].empty();
+        }
+        if (!nested)
+            return {};
+
+        // Level: one more than the highest level that has to go first
+        std::vector<std::size_t> level(count, npos);
+        std::vector<std::uint8_t> visiting(count);
+        std::vector<std::vector<std::size_t>> grouped{};
+        for (std::size_t idx{}; idx < count; ++idx)
+        {
+            std::vector<std::pair<std::size_t, std::size_t>> stack{{idx, 0}};
+            while (!stack.empty())
+            {
+                auto& [pos, edge] = stack.back();
+                if (level[pos] != npos)
+                {
+                    stack.pop_back();
+                    continue;
+                }
+                visiting[pos] = 1;
+                if (edge < before[pos].size())
+                {
+                    std::size_t other{before[pos][edge++]};
+                    if (level[other] == npos && !visiting[other])
+                        stack.push_back({other, 0});
+                    continue;
+                }
+
+                // A cycle (directories swapping names) is cut where it was found
+                std::size_t highest{0};
+                for (std::size_t other : before[pos])
+                {
+                    if (level[other] != npos)
+                        highest = std::max(highest, level[other] + 1);
+                }
+                level[pos] = highest;
+                visiting[pos] = 0;
+                if (grouped.size() <= highest)
+                    grouped.resize(highest + 1);
+                grouped[highest].push_back(pos);
+                stack.pop_back();
+            }
+        }
+        return grouped;
+    }
+
+    // Turn the batch into steps, returning the step that decides each result
+    std::vector<std::size_t> plan(const std::vector<Rename>& batch)
+    {
+        steps.clear();
+        std::size_t count{batch.size()};
+
+        // vacates[idx]: the rename that moves the file now at batch[idx].second
+        std::map<fs::path, std::size_t> sources{};
+        std::set<fs::path> targets{};
+        for (std::size_t idx{}; idx < count; ++idx)
+        {
+            sources[batch[idx].first] = idx;
+            targets.insert(batch[idx].second);
+        }
+        std::vector<std::size_t> vacates(count, npos);
+        for (std::size_t idx{}; idx < count; ++idx)
+        {
+            auto found{sources.find(batch[idx].second)};
+            if (found != sources.end() && found->second != idx)
+                vacates[idx] = found->second;
+        }
+
+        // Follow each chain to find the cycles (every name is moved at most once)
+        std::vector<std::uint8_t> state(count);     // 0 new, 1 on this chain, 2 done
+        std::vector<std::size_t> cycleStart{};
+        for (std::size_t idx{}; idx < count; ++idx)
+        {
+            std::vector<std::size_t> chain{};
+            std::size_t pos{idx};
+            while (pos != npos && state[pos] == 0)
+            {
+                state[pos] = 1;
+                chain.push_back(pos);
+                pos = vacates[pos];
+            }
+            if (pos != npos && state[pos] == 1)
+                cycleStart.push_back(pos);
+            for (std::size_t member : chain)
+                state[member] = 2;
+        }
+
+        // movedBy[idx]: the step that frees batch[idx].first
+        std::vector<std::size_t> movedBy(count, npos);
+        std::vector<std::size_t> resultStep(count, npos);
+        for (std::size_t start : cycleStart)
+        {
+            std::size_t other{vacates[start]};
+#ifdef __linux__
+            if (vacates[other] == start)
+            {
+                fs::path temp{tempName(batch[start].first, targets)};
+                targets.insert(temp);
+                steps.push_back(Step{batch[start].first, batch[other].first, npos, npos, true,
+                                     start, other, temp});
+                movedBy[start] = movedBy[other] = steps.size() - 1;
+                resultStep[start] = resultStep[other] = steps.size() - 1;
+                continue;
+            }
+#endif
+            fs::path temp{tempName(batch[start].first, targets)};
+            targets.insert(temp);
+            steps.push_back(Step{batch[start].first, temp});
+            movedBy[start] = steps.size() - 1;
+        }
+        for (std::size_t idx{}; idx < count; ++idx)
+        {
+            if (movedBy[idx] != npos)
+                continue;
+            steps.push_back(Step{batch[idx].first, batch[idx].second});
+            steps.back().rename = idx;
+            movedBy[idx] = resultStep[idx] = steps.size() - 1;
+        }
+        for (std::size_t start : cycleStart)
+        {
+            if (resultStep[start] != npos)
+                continue;
+            steps.push_back(Step{steps[movedBy[start]].to, batch[start].second});
+            steps.back().first = movedBy[start];
+            steps.back().rename = start;
+            resultStep[start] = steps.size() - 1;
+        }
+
+        // Link each step to the one emptying its new name
+        for (std::size_t idx{}; idx < count; ++idx)
+        {
+            if (vacates[idx] == npos || steps[resultStep[idx]].exchange)
+                continue;
+            steps[resultStep[idx]].after = movedBy[vacates[idx]];
+        }
+        return resultStep;
+    }
+
+    // Steps grouped so that each group only waits on earlier groups
+    std::vector<std::vector<std::size_t>> waves()
+    {
+        std::vector<std::size_t> depth(steps.size(), npos);
+        std::vector<std::vector<std::size_t>> grouped{};
+        for (std::size_t idx{}; idx < steps.size(); ++idx)
+        {
+            std::vector<std::size_t> chain{};
+            for (std::size_t pos{idx}; pos != npos && depth[pos] == npos; pos = steps[pos].after)
+                chain.push_back(pos);
+            for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+            {
+                std::size_t after{steps[*it].after};
+                std::size_t level{after == npos ? 0 : depth[after] + 1};
+                if (steps[*it].first != npos)
+                    level = std::max(level, depth[steps[*it].first] + 1);
+                depth[*it] = level;
+            }
+            if (grouped.size() <= depth[idx])
+                grouped.resize(depth[idx] + 1);
+            grouped[depth[idx]].push_back(idx);
+        }
+        return grouped;
+    }
+
+    static fs::path tempName(const fs::path& path, const std::set<fs::path>& taken)
+    {
+        std::error_code ec{};
+        fs::path temp{};
+        for (std::size_t num{}; temp.empty() || taken.contains(temp) || fs::exists(temp, ec); ++num)
+            temp = path.parent_path() / ("." + path.filename().string() + ".rename" + std::to_string(num));
+        return temp;
+    }
+
+    void openDirectories()
+    {
+#ifndef _WIN32
+        for (auto& step : steps)
+        {
+            for (const fs::path* path : {&step.from, &step.to})
+            {
+                fs::path dir{path->parent_path()};
+                if (!dirFds.contains(dir))
+                    dirFds[dir] = open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            }
+        }
+#endif
+    }
+
+    // Takes steps off the shared counter while this worker is within the limit
+    void worker(std::size_t id)
+    {
+        for (std::size_t idx{next++}; idx < wave->size(); idx = next++)
+        {
+            std::size_t stepIdx{(*wave)[idx]};
+            const Step& step{steps[stepIdx]};
+
+            // A failed step leaves its name taken (or its file under a temporary name)
+            if (step.first != npos && stepErrors[step.first])
+            {
+                stepErrors[stepIdx] = stepErrors[step.first];
+                continue;
+            }
+            if (step.after != npos && stepErrors[step.after])
+            {
+                stepErrors[stepIdx] = std::make_error_code(std::errc::file_exists);
+                continue;
+            }
+
+            auto start{std::chrono::steady_clock::now()};
+            stepErrors[stepIdx] = step.exchange ? exchangeOne(step) : renameOne(step.from, step.to);
+            std::int64_t latency{std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now() - start).count()};
+            adjust(latency);
+
+            if (!stepErrors[stepIdx] && *stepDone)
+                (*stepDone)(stepIdx);
+
+            // Park while there are more workers than the latency calls for
+            while (id && id >= workerLimit && next < wave->size())
+            {
+                std::unique_lock<std::mutex> lock{threadMutex};
+                limitRaised.wait_for(lock, std::chrono::milliseconds{1});
+            }
+        }
+    }
+
+    // Moving average of the latency decides how many workers should run
+    void adjust(std::int64_t latency)
+    {
+        std::int64_t average{averageLatency};
+        average = average ? (average * 7 + latency) / 8 : latency;
+        averageLatency = average;
+
+        std::size_t limit{static_cast<std::size_t>(average / fastRename) + 1};
+        limit = std::min({limit, maxWorkers, wave->size()});
+        std::size_t oldLimit{workerLimit.exchange(limit)};
+        if (limit <= oldLimit)
+            return;
+
+        std::lock_guard<std::mutex> lock{threadMutex};
+        while (threads.size() + 1 < limit && next < wave->size())
+        {
+            std::size_t id{threads.size() + 1};
+            threads.emplace_back([this, id]() { worker(id); });
+        }
+        limitRaised.notify_all();
+    }
+
+    std::error_code renameOne(const fs::path& from, const fs::path& to)
+    {
+        std::error_code ec{};
+#ifdef _WIN32
+        fs::rename(from, to, ec);
+#else
+        int oldDir{dirFds.at(from.parent_path())};
+        int newDir{dirFds.at(to.parent_path())};
+        if (oldDir < 0 || newDir < 0)
+            fs::rename(from, to, ec);
+        else if (renameat(oldDir, from.filename().c_str(), newDir, to.filename().c_str()) != 0)
+            ec = std::error_code{errno, std::generic_category()};
+#endif
+        return ec;
+    }
+
+    // Swap two files, through a temporary name if the filesystem can't exchange
+    std::error_code exchangeOne(const Step& step)
+    {
+#ifdef __linux__
+        int oldDir{dirFds.at(step.from.parent_path())};
+        int newDir{dirFds.at(step.to.parent_path())};
+        if (oldDir >= 0 && newDir >= 0 &&
+            renameat2(oldDir, step.from.filename().c_str(),
+                      newDir, step.to.filename().c_str(), RENAME_EXCHANGE) == 0)
+            return std::error_code{};
+#endif
+        std::error_code ec{renameOne(step.from, step.temp)};
+        if (ec)
+            return ec;
+        if ( (ec = renameOne(step.to, step.from)) )
+        {
+            renameOne(step.temp, step.from);
+            return ec;
+        }
+        return renameOne(step.temp, step.to);
+    }
+};
+
+#endif
@@ -0,0 +1,228 @@
+#ifndef FILENAMES_H
+#define FILENAMES_H
+
+#include <algorithm>  // For transform
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+
+
+// A menu entry. Its type (from the directory listing), stem/extension split
+// and lowercase name are worked out once instead of on every keyword.
+struct FileRecord
+{
+    fs::path path{};
+    std::string filename{};
+    std::string lowerName{};
+    std::size_t stemLength{};   // filename = stem + extension
+    bool isDirectory{};
+
+    FileRecord() = default;
+
+    explicit FileRecord(const fs::path& filePath, bool directory = false)
+        : path{filePath}, filename{filePath.filename().string()}, 
+          stemLength{filePath.stem().string().length()}, isDirectory{directory}
+        {
+            lowerName = filename;
+            transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
+        }
+
+    explicit FileRecord(const fs::directory_entry& entry)
+        : FileRecord(entry.path(), isDirectoryEntry(entry)) {}
+
+    std::string stem() const { return filename.substr(0, stemLength); }
+
+    std::string extension() const { return filename.substr(stemLength); }
+
+    // The same entry under a new name
+    FileRecord renamed(const fs::path& newPath) const
+    {
+        return FileRecord{newPath, isDirectory};
+    }
+
+private:
+    static bool isDirectoryEntry(const fs::directory_entry& entry)
+    {
+        std::error_code ec{};
+        return entry.is_directory(ec);
+    }
+};
+
+using MenuIndex = std::uint32_t;
+
+
+
+// Menu entries by index, stored contiguously and sorted by index. Erasing
+// only masks an entry, so it can be restored in place (rm/rm-). Lookups on
+// a full menu (index == position) are O(1), subsets use a binary search.
+class Filenames
+{
+    std::vector<MenuIndex> indexes{};
+    std::vector<FileRecord> records{};
+    std::vector<std::uint8_t> removed{};
+    std::size_t count{};
+
+    static constexpr std::size_t npos{static_cast<std::size_t>(-1)};
+
+public:
+    template <bool Const>
+    class Iterator
+    {
+        using Owner = std::conditional_t<Const, const Filenames, Filenames>;
+        using Record = std::conditional_t<Const, const FileRecord, FileRecord>;
+
+    public:
+        struct Entry
+        {
+            MenuIndex first;
+            Record& second;
+            const Entry* operator->() const { return this; }
+        };
+
+    private:
+        Owner* owner{};
+        std::size_t pos{};
+
+        void skipRemoved()
+        {
+            while (pos < owner->indexes.size() && owner->removed[pos])
+                ++pos;
+        }
+
+    public:
+        Iterator(Owner* filenames, std::size_t position)
+            : owner{filenames}, pos{position} { skipRemoved(); }
+
+        operator Iterator<true>() const { return {owner, pos}; }
+
+        Entry operator*() const { return {owner->indexes[pos], owner->records[pos]}; }
+        Entry operator->() const { return **this; }
+
+        Iterator& operator++()
+        {
+            ++pos;
+            skipRemoved();
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator old{*this};
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const Iterator& other) const { return pos == other.pos; }
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    iterator begin() { return {this, 0}; }
+    iterator end() { return {this, indexes.size()}; }
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, indexes.size()}; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return !count; }
+
+    // One past the highest index ever stored
+    MenuIndex indexEnd() const { return indexes.empty() ? 0 : indexes.back() + 1; }
+
+    bool contains(MenuIndex index) const
+    {
+        std::size_t pos{find(index)};
+        return pos != npos && !removed[pos];
+    }
+
+    const FileRecord& at(MenuIndex index) const
+    {
+        std::size_t pos{find(index)};
+        if (pos == npos || removed[pos])
+            throw std::out_of_range("Menu index " + std::to_string(index) + " not found");
+        return records[pos];
+    }
+
+    // Insert (or restore) the entry if missing, like std::map
+    FileRecord& operator[](MenuIndex index)
+    {
+        std::size_t pos{find(index)};
+        if (pos == npos)
+        {
+            auto it{std::lower_bound(indexes.begin(), indexes.end(), index)};
+            pos = it - indexes.begin();
+            indexes.insert(it, index);
+            records.insert(records.begin() + pos, FileRecord{});
+            removed.insert(removed.begin() + pos, 0);
+            ++count;
+        }
+        else if (removed[pos])
+        {
+            removed[pos] = 0;
+            ++count;
+        }
+        return records[pos];
+    }
+
+    // Append after the highest index, returning the new index
+    MenuIndex push_back(FileRecord record)
+    {
+        MenuIndex index{indexEnd()};
+        indexes.push_back(index);
+        records.push_back(std::move(record));
+        removed.push_back(0);
+        ++count;
+        return index;
+    }
+
+    void erase(MenuIndex index)
+    {
+        std::size_t pos{find(index)};
+        if (pos == npos || removed[pos])
+            return;
+        removed[pos] = 1;
+        records[pos] = FileRecord{};
+        --count;
+    }
+
+    void erase(const_iterator it) { erase(it->first); }
+
+    void clear()
+    {
+        indexes.clear();
+        records.clear();
+        removed.clear();
+        count = 0;
+    }
+
+    void reserve(std::size_t size)
+    {
+        indexes.reserve(size);
+        records.reserve(size);
+        removed.reserve(size);
+    }
+
+private:
+    std::size_t find(MenuIndex index) const
+    {
+        if (index < indexes.size() && indexes[index] == index)
+            return index;
+        auto it{std::lower_bound(indexes.begin(), indexes.end(), index)};
+        if (it == indexes.end() || *it != index)
+            return npos;
+        return it - indexes.begin();
+    }
+};
+
+#endif
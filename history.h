@@ -2,123 +2,193 @@
 #define HISTORY_H
 
 #include "colors.h"
+#include "filenames.h"
+#include "historylog.h"
+#include "journal.h"
+#include "pager.h"
 // #include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <map>
 #include <vector>
 #include <filesystem>
 #include <fstream>
 #include <string>
+#include <system_error>
 
 namespace fs = std::filesystem;
-using Filenames = std::map<int16_t, fs::path>;
 
 
 
 class HistoryData
 {
-    using OldNewFiles = std::map<fs::path, fs::path>;
+    using OldNewFiles = HistoryLog::OldNewFiles;
 
 public:
-    std::vector<OldNewFiles> historyData{};
-    fs::path currentPath{};
+    HistoryLog log;
     bool saveHistory{true};
+    RenameJournal journal;
 
     HistoryData(fs::path dir)
+        : log{fs::path{dir}.replace_filename("RenameHistory")}, journal{dir}
         {
-            currentPath = dir.replace_filename("RenameHistory.txt");
-            if (!fs::exists(currentPath))
+            if (log.created)
+                std::cout << "History folder created: " << fs::path{dir}.replace_filename("RenameHistory") << '\n';
+            migrate(dir.replace_filename("RenameHistory.txt"));
+            saveHistory = log.enabled();
+            if (!saveHistory)
             {
-                std::ofstream fileData{currentPath};
-                std::cout << "History file created: " << currentPath << '\n';
-                fileData << "on\n";
-                fileData.close();
+                setColor(Color::red);
+                std::cout << "\nHistory is turned off.\n";
+                resetColor();
             }
-            loadFromFile();
         }
 
-    void update(Filenames& newFiles, Filenames& oldFiles)
+    void add(const OldNewFiles& historyUpdate)
     {
-        OldNewFiles historyUpdate{};
-        for (auto& pair: newFiles)
+        if (!historyUpdate.empty())
+            log.append(historyUpdate);
+    }
+
+    std::size_t size()
+    {
+        return log.size();
+    }
+
+    bool empty()
+    {
+        return log.empty();
+    }
+
+    // Index 0 is the latest rename
+    OldNewFiles entry(std::size_t index)
+    {
+        return log.read(index);
+    }
+
+    // Every rename of one file, oldest first
+    std::vector<HistoryLog::Rename> trace(const fs::path& path)
+    {
+        return log.trace(path);
+    }
+
+    std::vector<fs::path> pathsNamed(const std::string& filename)
+    {
+        return log.pathsNamed(filename);
+    }
+
+    // A batch was cut short and some of its renames are not done
+    bool interrupted()
+    {
+        std::vector<RenameJournal::Rename> renames{};
+        std::vector<RenameJournal::LoggedStep> steps{};
+        if (!journal.load(renames, steps))
+            return false;
+        for (auto isDone : RenameJournal::renamesDone(renames.size(), steps))
         {
-            historyUpdate[oldFiles[pair.first]] = pair.second;
+            if (!isDone)
+                return true;
         }
-        if (historyData.size() >= 10 && !historyUpdate.empty())
-            historyData.pop_back();
-            
-        historyData.insert(historyData.begin(), historyUpdate);
+        return false;
     }
-    
-    void saveToFile()
+
+    // Offer to finish or undo a rename batch that was cut short
+    void recover()
     {
-        std::ofstream fileData{currentPath};
-        if (saveHistory)
-            fileData << "on\n";
-        else
-            fileData << "off\n";
+        std::vector<RenameJournal::Rename> renames{};
+        std::vector<RenameJournal::LoggedStep> steps{};
+        if (!journal.load(renames, steps))
+        {
+            journal.clear();
+            return;
+        }
+
+        std::vector<std::uint8_t> done{RenameJournal::renamesDone(renames.size(), steps)};
+        std::size_t doneCount{};
+        for (auto isDone : done)
+            doneCount += isDone;
 
-        for (auto& history : historyData)
+        std::string answer{};
+        if (doneCount < renames.size())
         {
-            for (auto& pair : history)
-            {
-                fileData << pair.first.string() << '\n';
-                fileData << pair.second.string() << '\n';
-            }
-            fileData << '\n';
+            setColor(Color::red);
+            std::cout << "\nA rename was interrupted (" << doneCount << " of " 
+                      << renames.size() << " files renamed).\n";
+            resetColor();
+            std::cout << "Enter f to finish it, u to undo it, or ENTER to leave it:\n> ";
+            std::getline(std::cin, answer);
         }
-        fileData.close();
-    }
 
-    void loadFromFile()
+        // Finish, or undo the steps done (temporary names and swaps included)
+        std::vector<RenameJournal::Failure> failures{};
+        if (answer == "f")
+            failures = journal.finish(renames, steps, done);
+        else if (answer == "u")
+            failures = journal.undo(renames.size(), steps, done);
+        for (auto& failure : failures)
+        {
+            setColor(Color::red);
+            std::cout << "Cannot rename " << failure.rename.first.string() << ": " 
+                      << failure.error.message() << '\n';
+            resetColor();
+        }
+        journal.clear();
+
+        // What is left renamed goes to history so it can be undone
+        OldNewFiles historyUpdate{};
+        for (std::size_t idx{}; idx < renames.size(); ++idx)
+        {
+            if (done[idx])
+                historyUpdate[renames[idx].first] = renames[idx].second;
+        }
+        if (saveHistory)
+            add(historyUpdate);
+    }
+    
+    // Move the old RenameHistory.txt (newest first) into the log
+    void migrate(const fs::path& oldFile)
     {
-        std::ifstream fileData{};
-        fileData.open(currentPath, std::ios::in);
-        if ( fileData.is_open() )
+        std::ifstream fileData{oldFile};
+        if ( !fileData.is_open() || !log.empty() )
+            return;
+
+        std::string line{};
+        std::string temp_string{};
+        OldNewFiles historyPoint{};
+        std::vector<OldNewFiles> oldHistory{};
+        getline(fileData, line);
+        if (line == "off")
+            log.setEnabled(false);
+
+        while(getline(fileData, line))
         {
-            std::string line{};
-            std::string temp_string{};
-            OldNewFiles historyPoint{};
-            getline(fileData, line);
-            if (line == "off")
+            if (line == "")
             {
-                setColor(Color::red);
-                std::cout << "\nHistory is turned off.\n";
-                resetColor();
-                saveHistory = false;
+                if (historyPoint.empty())
+                    break;
+                oldHistory.push_back(historyPoint);
+                historyPoint.clear();
+                continue;
             }
-            else if (line == "on")
-                saveHistory = true;
-
-            while(getline(fileData, line))
+            if (temp_string == "")
             {
-                if (line == "")
-                {
-                    if (historyPoint.empty())
-                        break;
-                    historyData.push_back(historyPoint);
-                    historyPoint.clear();
-                    continue;
-                }
-                if (temp_string == "")
-                {
-                    fs::path l{line};
-                    temp_string = l.generic_string();
-                }
-                else
-                {
-                    fs::path l{line};
-                    historyPoint[temp_string] = l.generic_string();
-                    temp_string = "";
-                }
+                fs::path l{line};
+                temp_string = l.generic_string();
+            }
+            else
+            {
+                fs::path l{line};
+                historyPoint[temp_string] = l.generic_string();
+                temp_string = "";
             }
-        fileData.close();
-        }
-        else
-        {
-            std::cout << "Error opening file: " << currentPath << "\n";
         }
+        fileData.close();
+
+        for (auto it = oldHistory.rbegin(); it != oldHistory.rend(); ++it)
+            log.append(*it);
+        std::error_code ec{};
+        fs::rename(oldFile, fs::path{oldFile}.replace_extension(".txt.bak"), ec);
     }
 
     void clear()
@@ -131,29 +201,43 @@ public:
         if (replacement == "q")
             return;
 
-        historyData.clear();
+        log.clear();
     }
 
     void toggle()
     {
         saveHistory = !saveHistory;
+        log.setEnabled(saveHistory);
     }
 
-    void removeEntry(std::int16_t index)
+    void removeEntry(std::size_t index)
     {
-        historyData.erase(historyData.begin() + index);
+        log.remove(index);
     }
 
-    void print()
+    // Keep an entry with only some of its renames (the rest were undone)
+    void replaceEntry(std::size_t index, const OldNewFiles& entry)
+    {
+        log.replace(index, entry);
+    }
+
+    // Only the entries on the pager's page are read
+    void print(const Pager& pager)
     {
         setColor(Color::blue);
         std::cout << "\nHistory:\n";
         resetColor();
-        std::int32_t idx{};
+        std::size_t idx{pager.first()};
         std::int16_t color{};
-        bool exists{};
-        for (auto& history : historyData)
+        for (std::size_t index{pager.first()}; index < pager.last(); ++index)
         {
+            OldNewFiles history{log.read(index)};
+            if (history.empty())
+            {
+                ++idx;
+                continue;
+            }
+
             if ( fs::exists(history.begin()->second) )
                 color = Color::green;
             else
@@ -173,22 +257,6 @@ public:
             ++idx;
         }
     }
-
-    std::pair<Filenames, Filenames> getFilenames(std::int32_t index)
-    {
-        std::int16_t idx{};
-        std::pair<Filenames, Filenames> filePaths{};
-        Filenames old_filenames{};
-        Filenames new_filenames{};
-        for (auto& pair : historyData[index])
-        {
-            old_filenames[idx] = pair.first;
-            new_filenames[idx] = pair.second;
-            ++idx;
-        }
-        filePaths = make_pair(old_filenames, new_filenames);
-        return filePaths;
-    }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,650 @@
+#ifndef HISTORYLOG_H
+#define HISTORYLOG_H
+
+#include "stats.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+
+
+// Rename history kept as an append-only log. Entries are written to numbered
+// segment files and never rewritten in place. index.txt is appended with one
+// line per change (new entry and where it is, removed entry, clear, on/off),
+// so start up only reads the index, and an entry is read from its segment
+// when it is needed. Removed entries are dropped from old segments by a
+// background compaction once they take up more space than the live ones.
+class HistoryLog
+{
+public:
+    using OldNewFiles = std::map<fs::path, fs::path>;
+    bool created{};                            // No history folder before
+
+    // One rename of a file, index as shown by !history
+    struct Rename
+    {
+        std::size_t index{};
+        fs::path oldPath{};
+        fs::path newPath{};
+    };
+
+private:
+    struct Location
+    {
+        std::uint64_t id{};
+        std::uint32_t segment{};
+        std::uint64_t offset{};
+        std::uint64_t length{};
+    };
+
+    // A rename into or out of a path: the entry and the path on the other side
+    struct Link
+    {
+        std::uint64_t id{};
+        std::string other{};
+    };
+    using Links = std::unordered_map<std::string, std::vector<Link>>;
+
+    static constexpr std::uint64_t segmentSize{4 << 20};
+    static constexpr std::uint64_t compactAfter{1 << 20};   // Bytes of removed entries
+
+    fs::path dir{};
+    std::vector<Location> entries{};           // Oldest first
+    std::uint64_t nextId{};
+    bool saveHistory{true};
+    std::uint32_t activeSegment{};
+    std::uint64_t activeSize{};
+    std::uint64_t liveBytes{};
+    std::uint64_t deadBytes{};
+    std::uint64_t retryAfter{};                // Dead bytes to wait for after a failed compaction
+    std::ofstream indexFile{};
+    std::thread compactor{};
+    bool compacting{};
+    std::mutex logMutex{};
+
+    // Inverted index for trace, built on first use. Links are in id order.
+    bool traceBuilt{};
+    Links renamedFrom{};                       // New path -> old
+    Links renamedTo{};                         // Old path -> new
+    std::unordered_map<std::string, std::set<std::string>> pathsByName{};
+
+public:
+    HistoryLog(const fs::path& logDir)
+        {
+            dir = logDir;
+            std::error_code ec{};
+            created = fs::create_directories(dir, ec);
+            load();
+            indexFile.open(dir / "index.txt", std::ios::app);
+            startCompaction();
+        }
+
+    ~HistoryLog()
+        {
+            if (compactor.joinable())
+                compactor.join();
+        }
+
+    HistoryLog(const HistoryLog&) = delete;
+    HistoryLog& operator=(const HistoryLog&) = delete;
+
+    bool empty()
+    {
+        std::lock_guard<std::mutex> lock{logMutex};
+        return entries.empty();
+    }
+
+    std::size_t size()
+    {
+        std::lock_guard<std::mutex> lock{logMutex};
+        return entries.size();
+    }
+
+    bool enabled()
+    {
+        std::lock_guard<std::mutex> lock{logMutex};
+        return saveHistory;
+    }
+
+    // Index 0 is the newest entry
+    OldNewFiles read(std::size_t index)
+    {
+        std::lock_guard<std::mutex> lock{logMutex};
+        if (index >= entries.size())
+            return OldNewFiles{};
+        return readEntry(entries[entries.size() - 1 - index]);
+    }
+
+    // Cost depends only on the size of the entry
+    void append(const OldNewFiles& entry)
+    {
+        std::lock_guard<std::mutex> lock{logMutex};
+        PhaseTimer timer{Phase::history, entry.size()};
+        if (activeSize >= segmentSize)
+            rotate();
+
+        std::string record{formatEntry(nextId, entry)};
+        timer.calls = 4;        // Segment open, write and close, index write
+        timer.bytes = record.size();
+        std::ofstream segment{segmentPath(activeSegment), std::ios::binary | std::ios::app};
+        segment << record;
+        segment.close();
+
+        Location location{nextId++, activeSegment, activeSize, record.size()};
+        activeSize += record.size();
+        liveBytes += record.size();
+        entries.push_back(location);
+        if (traceBuilt)
+            addLinks(location.id, entry);
+        indexFile << "entry " << location.id << ' ' << location.segment << ' '
+                  << location.offset << ' ' << location.length << std::endl;
+    }
+
+    // Rewrite one entry with the same id (a later index line wins on load)
+    void replace(std::size_t index, const OldNewFiles& entry)
+    {
+        {
+            std::lock_guard<std::mutex> lock{logMutex};
+            if (index >= entries.size())
+                return;
+            Location& location{entries[entries.size() - 1 - index]};
+            if (traceBuilt)
+                removeLinks(location.id, readEntry(location));
+            if (activeSize >= segmentSize)
+                rotate();
+
+            std::string record{formatEntry(location.id, entry)};
+            std::ofstream segment{segmentPath(activeSegment), std::ios::binary | std::ios::app};
+            segment << record;
+            segment.close();
+
+            liveBytes = liveBytes - location.length + record.size();
+            deadBytes += location.length;
+            location = Location{location.id, activeSegment, activeSize, record.size()};
+            activeSize += record.size();
+            if (traceBuilt)
+                addLinks(location.id, entry);
+            indexFile << "entry " << location.id << ' ' << location.segment << ' '
+                      << location.offset << ' ' << location.length << std::endl;
+        }
+        startCompaction();
+    }
+
+    void remove(std::size_t index)
+    {
+        {
+            std::lock_guard<std::mutex> lock{logMutex};
+            if (index >= entries.size())
+                return;
+            auto it{entries.end() - 1 - index};
+            if (traceBuilt)
+                removeLinks(it->id, readEntry(*it));
+            indexFile << "remove " << it->id << std::endl;
+            liveBytes -= it->length;
+            deadBytes += it->length;
+            entries.erase(it);
+        }
+        startCompaction();
+    }
+
+    void clear()
+    {
+        {
+            std::lock_guard<std::mutex> lock{logMutex};
+            indexFile << "clear" << std::endl;
+            deadBytes += liveBytes;
+            liveBytes = 0;
+            entries.clear();
+            renamedFrom.clear();
+            renamedTo.clear();
+            pathsByName.clear();
+        }
+        startCompaction();
+    }
+
+    void setEnabled(bool on)
+    {
+        std::lock_guard<std::mutex> lock{logMutex};
+        saveHistory = on;
+        indexFile << (on ? "on" : "off") << std::endl;
+    }
+
+    // Every rename of the file that is (or was) at path, oldest first. Each
+    // step is one hash lookup and a binary search, so the cost follows the
+    // length of the chain rather than the size of the history.
+    std::vector<Rename> trace(const fs::path& path)
+    {
+        std::lock_guard<std::mutex> lock{logMutex};
+        buildTrace();
+        std::vector<Rename> chain{};
+
+        // Back to the first name, through the latest rename into each path
+        std::string current{path.generic_string()};
+        std::uint64_t before{nextId};
+        while (const Link* link{latestBefore(renamedFrom, current, before)})
+        {
+            chain.push_back(Rename{historyIndex(link->id), link->other, current});
+            current = link->other;
+            before = link->id;
+        }
+        std::reverse(chain.begin(), chain.end());
+
+        // Forward to the newest name
+        current = path.generic_string();
+        std::uint64_t from{chain.empty() ? 0 : entryId(chain.back().index) + 1};
+        while (const Link* link{firstFrom(renamedTo, current, from)})
+        {
+            chain.push_back(Rename{historyIndex(link->id), current, link->other});
+            current = link->other;
+            from = link->id + 1;
+        }
+        return chain;
+    }
+
+    // Paths in history with this filename
+    std::vector<fs::path> pathsNamed(const std::string& filename)
+    {
+        std::lock_guard<std::mutex> lock{logMutex};
+        buildTrace();
+        std::vector<fs::path> paths{};
+        auto found{pathsByName.find(filename)};
+        if (found != pathsByName.end())
+        {
+            for (auto& path : found->second)
+                paths.push_back(path);
+        }
+        return paths;
+    }
+
+private:
+    void buildTrace()
+    {
+        if (traceBuilt)
+            return;
+        for (auto& location : entries)
+            addLinks(location.id, readEntry(location));
+        traceBuilt = true;
+    }
+
+    void addLinks(std::uint64_t id, const OldNewFiles& entry)
+    {
+        for (auto& [oldPath, newPath] : entry)
+        {
+            std::string oldName{oldPath.generic_string()};
+            std::string newName{newPath.generic_string()};
+            renamedFrom[newName].push_back(Link{id, oldName});
+            renamedTo[oldName].push_back(Link{id, newName});
+            pathsByName[oldPath.filename().string()].insert(oldName);
+            pathsByName[newPath.filename().string()].insert(newName);
+        }
+    }
+
+    void removeLinks(std::uint64_t id, const OldNewFiles& entry)
+    {
+        for (auto& [oldPath, newPath] : entry)
+        {
+            for (auto* links : {&renamedFrom[newPath.generic_string()], &renamedTo[oldPath.generic_string()]})
+            {
+                auto it{lowerBound(*links, id)};
+                if (it != links->end() && it->id == id)
+                    links->erase(it);
+            }
+        }
+    }
+
+    static std::vector<Link>::const_iterator lowerBound(const std::vector<Link>& links, std::uint64_t id)
+    {
+        return std::lower_bound(links.begin(), links.end(), id,
+                                [](const Link& link, std::uint64_t value) { return link.id < value; });
+    }
+
+    static const Link* latestBefore(const Links& links, const std::string& path, std::uint64_t id)
+    {
+        auto found{links.find(path)};
+        if (found == links.end())
+            return nullptr;
+        auto it{lowerBound(found->second, id)};
+        return it == found->second.begin() ? nullptr : &*(it - 1);
+    }
+
+    static const Link* firstFrom(const Links& links, const std::string& path, std::uint64_t id)
+    {
+        auto found{links.find(path)};
+        if (found == links.end())
+            return nullptr;
+        auto it{lowerBound(found->second, id)};
+        return it == found->second.end() ? nullptr : &*it;
+    }
+
+    // Position counted from the newest entry, as !history numbers them
+    std::size_t historyIndex(std::uint64_t id) const
+    {
+        auto it{std::lower_bound(entries.begin(), entries.end(), id,
+                                 [](const Location& location, std::uint64_t value) { return location.id < value; })};
+        return entries.end() - 1 - it;
+    }
+
+    std::uint64_t entryId(std::size_t index) const
+    {
+        return entries[entries.size() - 1 - index].id;
+    }
+
+    fs::path segmentPath(std::uint32_t segment) const
+    {
+        return dir / ("segment-" + std::to_string(segment) + ".log");
+    }
+
+    static std::string formatEntry(std::uint64_t id, const OldNewFiles& entry)
+    {
+        std::string record{"entry " + std::to_string(id) + ' ' + std::to_string(entry.size()) + '\n'};
+        for (auto& pair : entry)
+        {
+            record += pair.first.string() + '\n';
+            record += pair.second.string() + '\n';
+        }
+        return record;
+    }
+
+    OldNewFiles readEntry(const Location& location) const
+    {
+        OldNewFiles entry{};
+        PhaseTimer timer{Phase::history, 1};
+        timer.calls = 2;
+        timer.bytes = location.length;
+        std::ifstream segment{segmentPath(location.segment), std::ios::binary};
+        std::string record(location.length, '\0');
+        segment.seekg(location.offset);
+        if (!segment.read(record.data(), location.length))
+            return entry;
+
+        std::istringstream lines{record};
+        std::string line{};
+        std::string newPath{};
+        getline(lines, line);
+        while (getline(lines, line) && getline(lines, newPath))
+            entry[fs::path{line}.generic_string()] = fs::path{newPath}.generic_string();
+        return entry;
+    }
+
+    void rotate()
+    {
+        ++activeSegment;
+        activeSize = 0;
+    }
+
+    // Read the index, then pick up entries written after its last line
+    void load()
+    {
+        PhaseTimer timer{Phase::history};
+        std::map<std::uint64_t, Location> live{};
+        std::map<std::uint32_t, std::uint64_t> indexedEnd{};
+        std::ifstream index{dir / "index.txt"};
+        std::string line{};
+        while (getline(index, line))
+        {
+            timer.bytes += line.size() + 1;
+            std::istringstream words{line};
+            std::string kind{};
+            words >> kind;
+            Location location{};
+            if (kind == "entry" && words >> location.id >> location.segment >> location.offset >> location.length)
+            {
+                live[location.id] = location;
+                indexedEnd[location.segment] = std::max(indexedEnd[location.segment],
+                                                        location.offset + location.length);
+                nextId = std::max(nextId, location.id + 1);
+            }
+            else if (kind == "remove" && words >> location.id)
+                live.erase(location.id);
+            else if (kind == "clear")
+                live.clear();
+            else if (kind == "next" && words >> location.id)
+                nextId = std::max(nextId, location.id);
+            else if (kind == "on" || kind == "off")
+                saveHistory = kind == "on";
+        }
+
+        // Segments on disk, and how much of each is live
+        std::set<std::uint32_t> segments{};
+        std::error_code ec{};
+        for (fs::directory_iterator it{dir, ec}, end{}; !ec && it != end; it.increment(ec))
+        {
+            std::string name{it->path().filename().string()};
+            if (name.rfind("segment-", 0) == 0 && it->path().extension() == ".log")
+            {
+                try
+                {
+                    segments.insert(static_cast<std::uint32_t>(std::stoul(name.substr(8))));
+                }
+                catch(const std::exception& e) {}
+            }
+        }
+
+        std::uint32_t newestIndexed{indexedEnd.empty() ? 0 : indexedEnd.rbegin()->first};
+        std::ofstream appendIndex{dir / "index.txt", std::ios::app};
+        for (std::uint32_t segment : segments)
+        {
+            if (segment >= newestIndexed)
+                scanTail(segment, indexedEnd[segment], live, appendIndex);
+        }
+
+        std::uint64_t total{};
+        for (std::uint32_t segment : segments)
+            total += fs::file_size(segmentPath(segment), ec);
+        for (auto& pair : live)
+        {
+            entries.push_back(pair.second);
+            liveBytes += pair.second.length;
+        }
+        deadBytes = total > liveBytes ? total - liveBytes : 0;
+
+        activeSegment = segments.empty() ? 0 : *segments.rbegin();
+        activeSize = fs::file_size(segmentPath(activeSegment), ec);
+        if (ec)
+            activeSize = 0;
+
+        // Index read, directory listed, index opened, segment sizes
+        timer.items = entries.size();
+        timer.calls += 4 + segments.size();
+    }
+
+    // Entries written to a segment but not to the index (stopped in between)
+    void scanTail(std::uint32_t segment, std::uint64_t offset,
+                  std::map<std::uint64_t, Location>& live, std::ofstream& appendIndex)
+    {
+        stats.count(Phase::history, 1);
+        std::ifstream file{segmentPath(segment), std::ios::binary};
+        file.seekg(offset);
+        std::string line{};
+        while (getline(file, line))
+        {
+            std::istringstream words{line};
+            std::string kind{};
+            Location location{0, segment, offset, 0};
+            std::size_t count{};
+            if (!(words >> kind >> location.id >> count) || kind != "entry")
+                return;
+
+            std::uint64_t length{line.size() + 1};
+            for (std::size_t idx{}; idx < count * 2; ++idx)
+            {
+                if (!getline(file, line) || file.eof())
+                    return;
+                length += line.size() + 1;
+            }
+            location.length = length;
+            offset += length;
+            if (location.id < nextId)
+                continue;
+
+            live[location.id] = location;
+            nextId = location.id + 1;
+            appendIndex << "entry " << location.id << ' ' << location.segment << ' '
+                        << location.offset << ' ' << location.length << '\n';
+        }
+    }
+
+    void startCompaction()
+    {
+        std::lock_guard<std::mutex> lock{logMutex};
+        if (compacting || deadBytes <= liveBytes || deadBytes <= std::max(compactAfter, retryAfter))
+            return;
+        if (compactor.joinable())
+            compactor.join();
+        compacting = true;
+        compactor = std::thread{[this]() { compact(); }};
+    }
+
+    // Copy live entries out of the old segments, then swap in a new index.
+    // The old segments are only removed once the new segment, the index and
+    // the directory are on disk. Until the new index is in place a failure
+    // drops the new segment; after that the new segment is what the index
+    // refers to, so it stays and only the removal of the old ones waits.
+    void compact()
+    {
+        std::vector<Location> moving{};
+        std::uint32_t target{};
+        {
+            std::lock_guard<std::mutex> lock{logMutex};
+            moving = entries;
+            target = activeSegment + 1;
+            activeSegment += 2;         // New entries go after the compacted segment
+            activeSize = 0;
+        }
+
+        // Old segments are only deleted below, under the lock, so reading is safe
+        std::map<std::uint64_t, Location> moved{};
+        std::ofstream out{segmentPath(target), std::ios::binary | std::ios::trunc};
+        std::uint64_t offset{};
+        for (auto& location : moving)
+        {
+            std::ifstream segment{segmentPath(location.segment), std::ios::binary};
+            std::string record(location.length, '\0');
+            segment.seekg(location.offset);
+            if (!segment.read(record.data(), location.length) || !(out << record))
+                break;
+            moved[location.id] = Location{location.id, target, offset, location.length};
+            offset += location.length;
+        }
+        out.close();
+
+        std::lock_guard<std::mutex> lock{logMutex};
+        if (!out || moved.size() != moving.size() || !syncPath(segmentPath(target)))
+        {
+            abortCompaction(target);
+            return;
+        }
+
+        std::vector<Location> compacted{entries};
+        for (auto& location : compacted)
+        {
+            auto found{moved.find(location.id)};
+            if (found != moved.end())
+                location = found->second;
+        }
+
+        // Rewrite the index from the live state
+        indexFile.close();
+        bool written{};
+        {
+            std::ofstream index{dir / "index.tmp", std::ios::trunc};
+            index << (saveHistory ? "on" : "off") << '\n';
+            index << "next " << nextId << '\n';
+            for (auto& location : compacted)
+                index << "entry " << location.id << ' ' << location.segment << ' '
+                      << location.offset << ' ' << location.length << '\n';
+            index.close();
+            written = index && syncPath(dir / "index.tmp");
+        }
+        std::error_code ec{};
+        if (written)
+            fs::rename(dir / "index.tmp", dir / "index.txt", ec);
+        indexFile.open(dir / "index.txt", std::ios::app);
+        if (!written || ec)
+        {
+            fs::remove(dir / "index.tmp", ec);
+            abortCompaction(target);
+            return;
+        }
+
+        // The new index is in place: from here on it is the log
+        entries = compacted;
+        liveBytes = 0;
+        for (auto& location : entries)
+            liveBytes += location.length;
+
+        // Old segments go once the rename is on disk. If it can't be synced
+        // they are kept (a crash could bring the old index back) and a later
+        // compaction removes them.
+        bool synced{};
+        for (int attempt{}; attempt < 3 && !synced; ++attempt)
+            synced = syncPath(dir);
+        if (!synced)
+        {
+            retryAfter = deadBytes * 2;
+            compacting = false;
+            return;
+        }
+        for (std::uint32_t segment{}; segment < target; ++segment)
+            fs::remove(segmentPath(segment), ec);
+
+        deadBytes = offset + activeSize > liveBytes ? offset + activeSize - liveBytes : 0;
+        retryAfter = 0;
+        compacting = false;
+    }
+
+    // Keep the old segments and index. Wait for twice the dead bytes before
+    // trying again, so a failing disk doesn't get a full copy on every change.
+    void abortCompaction(std::uint32_t target)
+    {
+        std::error_code ec{};
+        fs::remove(segmentPath(target), ec);
+        retryAfter = deadBytes * 2;
+        compacting = false;
+    }
+
+    // Flush a file (or a directory's entries) to disk
+    static bool syncPath(const fs::path& path)
+    {
+#ifdef _WIN32
+        if (fs::is_directory(path))
+            return true;
+        int fd{_wopen(path.c_str(), _O_RDWR | _O_BINARY)};
+        if (fd < 0)
+            return false;
+        bool synced{_commit(fd) == 0};
+        _close(fd);
+#else
+        int fd{open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+        if (fd < 0)
+            return false;
+        bool synced{fsync(fd) == 0};
+        close(fd);
+#endif
+        stats.count(Phase::history, 1);
+        return synced;
+    }
+};
+
+#endif
@@ -0,0 +1,579 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "executor.h"
+#include "stats.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+
+
+// Write-ahead log for one rename batch. The renames are written and synced
+// before the first of them, then the steps of each level (temporary names
+// and exchanges included, with the file each one moves) before the level
+// runs. Finished steps are appended in groups: the directories touched by a
+// group are synced, then its "done" lines. The file is removed when the
+// batch ends, so finding it on start up means a batch was interrupted.
+//
+// Layout: "batch N", N pairs of old/new path lines, then for each level
+// "steps M" and M steps (a "step" line, then from, to and temp path lines),
+// and "done #" lines numbering the steps of all levels in order.
+class RenameJournal
+{
+public:
+    using Rename = std::pair<fs::path, fs::path>;
+    using Step = RenameExecutor::Step;
+
+    static constexpr std::size_t npos{RenameExecutor::npos};
+
+    // A step of an interrupted batch. after/first number steps of all levels.
+    struct LoggedStep
+    {
+        Step step{};
+        std::size_t level{};
+        std::uint64_t fromId{};     // File moved by the step (see fileId)
+        std::uint64_t toId{};       // File at "to" before an exchange
+        bool done{};
+    };
+
+    // A step recovery could not do or undo
+    struct Failure
+    {
+        Rename rename{};
+        std::error_code error{};
+    };
+
+private:
+    static constexpr std::size_t groupSize{512};
+    static constexpr std::chrono::milliseconds groupTime{20};
+
+    fs::path journalPath{};
+    std::FILE* file{};
+    std::vector<Step> planned{};              // Steps of the running batch, all levels
+    std::vector<std::uint64_t> plannedIds{};
+    std::size_t levelStart{};                 // First step of the running level
+    std::vector<std::size_t> pending{};
+    std::chrono::steady_clock::time_point lastSync{};
+    std::mutex journalMutex{};
+
+public:
+    RenameJournal(fs::path dir)
+        {
+            journalPath = dir.replace_filename("RenameJournal.txt");
+        }
+
+    ~RenameJournal()
+        {
+            if (file)
+                std::fclose(file);
+        }
+
+    RenameJournal(const RenameJournal&) = delete;
+    RenameJournal& operator=(const RenameJournal&) = delete;
+
+    // Rename a batch with the journal kept up to date
+    std::vector<std::error_code> run(const std::vector<Rename>& renames)
+    {
+        PhaseTimer timer{Phase::rename, renames.size()};
+        timer.calls = renames.size();
+        begin(renames);
+        RenameExecutor executor{};
+        std::vector<std::error_code> results{executor.run(renames,
+            [this](const std::vector<Step>& steps) { plan(steps); },
+            [this](std::size_t step) { committed(step); })};
+        end();
+        return results;
+    }
+
+    // Write the renames to disk before anything is renamed
+    void begin(const std::vector<Rename>& renames)
+    {
+        planned.clear();
+        plannedIds.clear();
+        pending.clear();
+        file = std::fopen(journalPath.string().c_str(), "w");
+        if (!file)
+            return;
+
+        std::fprintf(file, "batch %zu\n", renames.size());
+        for (auto& rename : renames)
+        {
+            std::fprintf(file, "%s\n", rename.first.string().c_str());
+            std::fprintf(file, "%s\n", rename.second.string().c_str());
+        }
+        stats.count(Phase::rename, 1, static_cast<std::uint64_t>(std::ftell(file)));
+        syncFile();
+        syncDirectory(journalPath.parent_path());     // The new file's entry
+        lastSync = std::chrono::steady_clock::now();
+    }
+
+    // Write the steps of a level before any of them runs
+    void plan(const std::vector<Step>& steps)
+    {
+        std::lock_guard<std::mutex> lock{journalMutex};
+        levelStart = planned.size();
+        if (!file)
+            return;
+
+        long start{std::ftell(file)};
+        std::fprintf(file, "steps %zu\n", steps.size());
+        for (const Step& levelStep : steps)
+        {
+            Step step{levelStep};
+            for (std::size_t* index : {&step.after, &step.first})
+            {
+                if (*index != npos)
+                    *index += levelStart;
+            }
+
+            // A step out of a temporary name moves the file its first step did
+            std::uint64_t fromId{step.first != npos ? plannedIds[step.first] : fileId(step.from)};
+            std::uint64_t toId{step.exchange ? fileId(step.to) : 0};
+            std::fprintf(file, "step %d %zu %zu %zu %zu %llu %llu\n", step.exchange ? 1 : 0,
+                         step.rename, step.partner, step.after, step.first,
+                         static_cast<unsigned long long>(fromId),
+                         static_cast<unsigned long long>(toId));
+            std::fprintf(file, "%s\n", step.from.string().c_str());
+            std::fprintf(file, "%s\n", step.to.string().c_str());
+            std::fprintf(file, "%s\n", step.temp.string().c_str());
+            planned.push_back(step);
+            plannedIds.push_back(fromId);
+        }
+        stats.count(Phase::rename, steps.size(), static_cast<std::uint64_t>(std::ftell(file) - start));
+        syncFile();
+    }
+
+    // Called from the rename workers for each finished step of the level
+    void committed(std::size_t step)
+    {
+        std::lock_guard<std::mutex> lock{journalMutex};
+        if (!file)
+            return;
+        pending.push_back(levelStart + step);
+        if (pending.size() >= groupSize || std::chrono::steady_clock::now() - lastSync >= groupTime)
+            syncGroup();
+    }
+
+    // The batch is over: nothing is left to recover
+    void end()
+    {
+        flush();
+        if (file)
+            std::fclose(file);
+        file = nullptr;
+        planned.clear();
+        plannedIds.clear();
+        clear();
+    }
+
+    // Renames and steps of an interrupted batch, and which steps are done
+    bool load(std::vector<Rename>& renames, std::vector<LoggedStep>& steps) const
+    {
+        std::ifstream fileData{journalPath};
+        std::string line{};
+        if (!fileData.is_open() || !getline(fileData, line) || line.rfind("batch ", 0) != 0)
+            return false;
+
+        std::size_t count{};
+        try
+        {
+            count = std::stoull(line.substr(6));
+        }
+        catch(const std::exception& e)
+        {
+            return false;
+        }
+
+        // A plan cut short was never started
+        std::string newPath{};
+        for (std::size_t idx{}; idx < count; ++idx)
+        {
+            if (!getline(fileData, line) || !getline(fileData, newPath))
+                return false;
+            renames.emplace_back(line, newPath);
+        }
+
+        // Levels are synced before they run: one cut short never ran, nor did those after it
+        std::vector<std::uint8_t> logged{};
+        std::size_t level{};
+        while (getline(fileData, line))
+        {
+            if (line.rfind("steps ", 0) == 0)
+            {
+                std::vector<LoggedStep> levelSteps{};
+                if (!readSteps(fileData, line, level, levelSteps))
+                    break;
+                steps.insert(steps.end(), levelSteps.begin(), levelSteps.end());
+                ++level;
+            }
+            else if (line.rfind("done ", 0) == 0)
+            {
+                std::size_t index{};
+                std::istringstream{line.substr(5)} >> index;
+                if (index < steps.size())
+                {
+                    logged.resize(steps.size());
+                    logged[index] = 1;
+                }
+            }
+        }
+        logged.resize(steps.size());
+
+        // Steps after the last synced group are found on disk. A step that is
+        // done means the steps it waited for are done too.
+        std::vector<std::size_t> doneSteps{};
+        for (std::size_t idx{}; idx < steps.size(); ++idx)
+        {
+            steps[idx].done = isDone(steps[idx], logged[idx]);
+            if (steps[idx].done)
+                doneSteps.push_back(idx);
+        }
+        while (!doneSteps.empty())
+        {
+            const Step& step{steps[doneSteps.back()].step};
+            doneSteps.pop_back();
+            for (std::size_t before : {step.after, step.first})
+            {
+                if (before < steps.size() && !steps[before].done)
+                {
+                    steps[before].done = true;
+                    doneSteps.push_back(before);
+                }
+            }
+        }
+        return true;
+    }
+
+    // Which renames of the batch are done, from the steps that finish them
+    static std::vector<std::uint8_t> renamesDone(std::size_t count, const std::vector<LoggedStep>& steps)
+    {
+        std::vector<std::uint8_t> done(count);
+        for (auto& logged : steps)
+        {
+            for (std::size_t index : {logged.step.rename, logged.step.partner})
+            {
+                if (index < count)
+                    done[index] = logged.done;
+            }
+        }
+        return done;
+    }
+
+    // Do the steps left, level by level, then the renames of levels never started
+    std::vector<Failure> finish(const std::vector<Rename>& renames, std::vector<LoggedStep>& steps,
+                                std::vector<std::uint8_t>& done)
+    {
+        std::vector<Failure> failures{};
+        settle(steps, failures);
+        std::size_t levels{steps.empty() ? 0 : steps.back().level + 1};
+        for (std::size_t level{}; level < levels; ++level)
+            replay(steps, level, true, failures);
+        done = renamesDone(renames.size(), steps);
+
+        std::vector<std::uint8_t> covered(renames.size());
+        for (auto& logged : steps)
+        {
+            for (std::size_t index : {logged.step.rename, logged.step.partner})
+            {
+                if (index < renames.size())
+                    covered[index] = 1;
+            }
+        }
+        std::vector<Rename> rest{};
+        std::vector<std::size_t> restIndex{};
+        for (std::size_t idx{}; idx < renames.size(); ++idx)
+        {
+            if (covered[idx])
+                continue;
+            rest.push_back(renames[idx]);
+            restIndex.push_back(idx);
+        }
+        if (rest.empty())
+            return failures;
+
+        std::vector<std::error_code> results{run(rest)};
+        for (std::size_t pos{}; pos < rest.size(); ++pos)
+        {
+            if (results[pos])
+                failures.push_back(Failure{rest[pos], results[pos]});
+            else
+                done[restIndex[pos]] = 1;
+        }
+        return failures;
+    }
+
+    // Undo the steps done, last level first
+    std::vector<Failure> undo(std::size_t count, std::vector<LoggedStep>& steps,
+                              std::vector<std::uint8_t>& done)
+    {
+        std::vector<Failure> failures{};
+        settle(steps, failures);
+        for (std::size_t level{steps.empty() ? 0 : steps.back().level + 1}; level-- > 0; )
+            replay(steps, level, false, failures);
+        done = renamesDone(count, steps);
+        return failures;
+    }
+
+    void clear()
+    {
+        std::error_code ec{};
+        fs::remove(journalPath, ec);
+    }
+
+private:
+    // Last group of "done" lines before the batch ends
+    void flush()
+    {
+        std::lock_guard<std::mutex> lock{journalMutex};
+        if (file && !pending.empty())
+            syncGroup();
+    }
+
+    void syncGroup()
+    {
+#ifndef _WIN32
+        // The renames have to be on disk before the journal says so
+        std::set<fs::path> dirs{};
+        for (std::size_t index : pending)
+        {
+            dirs.insert(planned[index].from.parent_path());
+            dirs.insert(planned[index].to.parent_path());
+        }
+        for (auto& dir : dirs)
+            syncDirectory(dir);
+        stats.count(Phase::rename, dirs.size() * 3);
+#endif
+        long start{std::ftell(file)};
+        for (std::size_t index : pending)
+            std::fprintf(file, "done %zu\n", index);
+        stats.count(Phase::rename, 0, static_cast<std::uint64_t>(std::ftell(file) - start));
+        syncFile();
+        pending.clear();
+        lastSync = std::chrono::steady_clock::now();
+    }
+
+    void syncFile()
+    {
+        stats.count(Phase::rename, 2);     // Write and sync
+        std::fflush(file);
+#ifdef _WIN32
+        _commit(_fileno(file));
+#else
+        fsync(fileno(file));
+#endif
+    }
+
+    static void syncDirectory(const fs::path& dir)
+    {
+#ifndef _WIN32
+        int fd{open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)};
+        if (fd < 0)
+            return;
+        fsync(fd);
+        close(fd);
+#endif
+    }
+
+    // Which file is at a path (its inode), 0 when there is none. Windows has
+    // no exchanges, so whether the path exists is enough there.
+    static std::uint64_t fileId(const fs::path& path)
+    {
+#ifdef _WIN32
+        std::error_code ec{};
+        return fs::exists(path, ec) ? 1 : 0;
+#else
+        struct stat status{};
+        return lstat(path.c_str(), &status) == 0 ? static_cast<std::uint64_t>(status.st_ino) : 0;
+#endif
+    }
+
+    // A "steps M" block. False when it was cut short.
+    static bool readSteps(std::ifstream& fileData, const std::string& header, std::size_t level,
+                          std::vector<LoggedStep>& steps)
+    {
+        std::size_t count{};
+        std::istringstream{header.substr(6)} >> count;
+        std::string line{};
+        std::string from{};
+        std::string to{};
+        std::string temp{};
+        for (std::size_t idx{}; idx < count; ++idx)
+        {
+            if (!getline(fileData, line) || line.rfind("step ", 0) != 0 ||
+                !getline(fileData, from) || !getline(fileData, to) || !getline(fileData, temp))
+                return false;
+
+            LoggedStep logged{};
+            int exchange{};
+            unsigned long long fromId{};
+            unsigned long long toId{};
+            std::istringstream fields{line.substr(5)};
+            fields >> exchange >> logged.step.rename >> logged.step.partner
+                   >> logged.step.after >> logged.step.first >> fromId >> toId;
+            if (!fields)
+                return false;
+            logged.step.exchange = exchange;
+            logged.step.from = from;
+            logged.step.to = to;
+            logged.step.temp = temp;
+            logged.level = level;
+            logged.fromId = fromId;
+            logged.toId = toId;
+            steps.push_back(logged);
+        }
+        return true;
+    }
+
+    // Where the files are decides, when they can be told apart. Otherwise the
+    // journal's "done" line does.
+    static bool isDone(const LoggedStep& logged, bool loggedDone)
+    {
+        std::uint64_t atFrom{fileId(logged.step.from)};
+        std::uint64_t atTo{fileId(logged.step.to)};
+        if (logged.step.exchange)
+        {
+            if (atFrom == logged.toId && atTo == logged.fromId)
+                return true;
+            if (atFrom == logged.fromId && atTo == logged.toId)
+                return false;
+            return loggedDone;
+        }
+        if (logged.fromId && atFrom == logged.fromId)
+            return false;
+        if (logged.fromId && atTo == logged.fromId)
+            return true;
+        return loggedDone;
+    }
+
+    // An exchange through its temporary name that was cut short is put back
+    static void settle(std::vector<LoggedStep>& steps, std::vector<Failure>& failures)
+    {
+        for (auto& logged : steps)
+        {
+            const Step& step{logged.step};
+            if (!step.exchange || logged.done || step.temp.empty() ||
+                !logged.fromId || fileId(step.temp) != logged.fromId)
+                continue;
+            std::error_code ec{};
+            if (fileId(step.from) == logged.toId)
+                fs::rename(step.from, step.to, ec);
+            if (!ec)
+                fs::rename(step.temp, step.from, ec);
+            if (ec)
+                failures.push_back(Failure{Rename{step.temp, step.from}, ec});
+        }
+    }
+
+    // Do (forward) or undo the steps of one level. A step waits for the steps
+    // it comes after to be done, and is undone only once they are undone. A
+    // step that fails holds back the ones waiting for it.
+    static void replay(std::vector<LoggedStep>& steps, std::size_t level, bool forward,
+                       std::vector<Failure>& failures)
+    {
+        std::vector<std::size_t> members{};
+        for (std::size_t idx{}; idx < steps.size(); ++idx)
+        {
+            if (steps[idx].level == level && steps[idx].done != forward)
+                members.push_back(idx);
+        }
+
+        std::unordered_map<std::size_t, std::size_t> waiting{};
+        std::unordered_map<std::size_t, std::vector<std::size_t>> released{};
+        for (std::size_t idx : members)
+        {
+            for (std::size_t before : {steps[idx].step.after, steps[idx].step.first})
+            {
+                if (before >= steps.size() || steps[before].done == forward)
+                    continue;
+                std::size_t waits{forward ? idx : before};
+                ++waiting[waits];
+                released[forward ? before : idx].push_back(waits);
+            }
+        }
+
+        std::vector<std::size_t> ready{};
+        for (std::size_t idx : members)
+        {
+            if (!waiting[idx])
+                ready.push_back(idx);
+        }
+        std::unordered_map<std::size_t, bool> blocked{};
+        while (!ready.empty())
+        {
+            std::size_t idx{ready.back()};
+            ready.pop_back();
+            const Step& step{steps[idx].step};
+            std::error_code ec{blocked[idx] ? std::make_error_code(std::errc::file_exists)
+                                            : apply(step, forward)};
+            if (ec)
+                failures.push_back(Failure{forward ? Rename{step.from, step.to}
+                                                   : Rename{step.to, step.from}, ec});
+            else
+                steps[idx].done = forward;
+
+            for (std::size_t next : released[idx])
+            {
+                blocked[next] = blocked[next] || ec;
+                if (--waiting[next] == 0)
+                    ready.push_back(next);
+            }
+        }
+    }
+
+    // One step of recovery, never replacing a file that is in the way
+    static std::error_code apply(const Step& step, bool forward)
+    {
+        std::error_code ec{};
+        if (step.exchange)
+        {
+#ifdef __linux__
+            if (renameat2(AT_FDCWD, step.from.c_str(), AT_FDCWD, step.to.c_str(), RENAME_EXCHANGE) == 0)
+                return ec;
+#endif
+            if (fs::exists(step.temp, ec))
+                return std::make_error_code(std::errc::file_exists);
+            fs::rename(step.from, step.temp, ec);
+            if (ec)
+                return ec;
+            fs::rename(step.to, step.from, ec);
+            if (ec)
+            {
+                std::error_code back{};
+                fs::rename(step.temp, step.from, back);
+                return ec;
+            }
+            fs::rename(step.temp, step.to, ec);
+            return ec;
+        }
+
+        const fs::path& from{forward ? step.from : step.to};
+        const fs::path& to{forward ? step.to : step.from};
+        if (fs::exists(to, ec) && !fs::equivalent(from, to, ec))
+            return std::make_error_code(std::errc::file_exists);
+        fs::rename(from, to, ec);
+        return ec;
+    }
+};
+
+#endif
@@ -1,8 +1,14 @@
 #include "rnFunctions.h"
 #include "colors.h"
 #include "history.h"
+#include "snapshot.h"
+#include "conflicts.h"
+#include "chain.h"
+#include "pager.h"
+#include "stats.h"
 #include "textCount.cpp"
 #include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <set>
@@ -10,7 +16,6 @@
 #include <string_view>
 #include <regex>
 
-using Filenames = std::map<int16_t, fs::path>;
 
 
 void keywordHelpMenu()
@@ -26,6 +31,9 @@ void keywordHelpMenu()
         "\n!rnsubs              Match a folder's filenames (subs) to menu stems."
         "\n!lower               Lowercase every letter."
         "\n!cap                 Capitalize every word."
+        "\nA | B | ...          Chain keywords (!dots, !cap, !lower, PAT -> NEW,"
+        "\n                     between L R -> NEW), renaming each file once."
+        "\n                     Without any of them, | is searched for in names."
 
         "\n\nMenu keywords:"
         "\n!index               Show index numbers for filenames."
@@ -35,7 +43,10 @@ void keywordHelpMenu()
         "\nrmfolders, rmfiles   Remove all folders or files."
         "\nchdir, adir, rmdir   Change, add, or remove a working directory."
         "\nadir+                Add all menu folders to working directories."
+        "\nadir++ (#) (-pat)    Add all subfolders (# levels), skipping pat folders."
         "\n!pwd                 Print work directories."
+        "\n!next, !prev         Show the next/previous page of the menu or preview."
+        "\n!page #, !pagesize # Go to page #, or show # filenames a page (0: all)."
 
         "\n\nPattern matches:"
         "\n#begin               The start of filename."
@@ -52,6 +63,8 @@ void keywordHelpMenu()
         "\n!print               Creates a text file with menu list."
         "\n!history             Show a list of rename history. Undo past renames."
         "\n!undo                Undo the last rename."
+        "\n!trace [name]        Show every name a file has had."
+        "\n!stats (json (file)) Show time spent in each phase of the last command."
         "\n!togglehistory       Pause/unpause saving history."
         "\nq, exit, ''          Quit.\n\n";
 
@@ -65,13 +78,14 @@ void keywordHelpMenu()
 
 
 void keywordDefaultReplace(std::string& pattern, Filenames& filePaths, 
-                           HistoryData& history)
+                           DirectorySnapshot& snapshot, HistoryData& history)
 {
     Filenames matchedPaths{};
-    std::string filename{};
     std::int16_t set_index{getIndex(pattern)}; // keyword #index
+    const Pattern compiledPattern{pattern};
 
     //Check for matches
+    PhaseTimer matching{Phase::match, filePaths.size()};
     if (pattern == "#begin" || pattern == "#end")
         matchedPaths = filePaths;
 
@@ -79,20 +93,11 @@ void keywordDefaultReplace(std::string& pattern, Filenames& filePaths,
     {
         for (const auto& pair: filePaths)
         {
-            if (pattern == "#ext" && pair.second.has_extension() && !fs::is_directory(pair.second))
-                matchedPaths[pair.first] = pair.second;
-
-            else if (pattern.rfind("#index", 0) == 0 && set_index <= pair.second.filename().string().length())
-                matchedPaths[pair.first] = pair.second;
-
-            else
-            {
-            filename = lowercase( pair.second.filename().string() );
-            if ( checkPatternWithRegex(filename, lowercase(pattern)) )
+            if ( patternMatches(pair.second, pattern, compiledPattern, set_index) )
                 matchedPaths[pair.first] = pair.second;
-            }
         }
     }
+    matching.stop();
     
     // Exit function if no matches found
     if ( !matchedPaths.size() )
@@ -100,95 +105,106 @@ void keywordDefaultReplace(std::string& pattern, Filenames& filePaths,
         redErrorMessage("No filenames to change.");
         return;
     }
-    // Print a preview with pattern highlighted
-    else
+
+    // Print a preview page with pattern highlighted, then get the replacement
+    // (or a page to move to)
+    Pager pager{matchedPaths.size()};
+    std::string replacement{};
+    do
     {
-        std::cout << '\n';
-        for (auto& pair : matchedPaths)
+        PhaseTimer previewing{Phase::preview, pager.last() - pager.first()};
+        screen << '\n';
+        std::size_t row{};
+        for (auto pair : matchedPaths)
         {
-            defaultPrintFilenameWithColor(pair.second, pattern);
+            if (row >= pager.last())
+                break;
+            if (pager.visible(row++))
+                defaultPrintFilenameWithColor(pair.second, compiledPattern);
         }
-    }
-    // Get second input for replacement
-    std::cout << "\nEnter replacement pattern (or q to quit):\n> "; 
-    std::string replacement{};
-    std::getline(std::cin, replacement);
+        printPageSummary(pager, '\n' + std::to_string(matchedPaths.size()) + " of " +
+                                std::to_string(filePaths.size()) + " filenames match.");
+        previewing.stop();
+        screen.flush();
+        replacement = readInput("\nEnter replacement pattern (or q to quit):\n> ");
+    } while (pager.command(replacement));
     std::cout << '\n';
     if (replacement == "q")
         return;
 
-    // Get new filenames
-    std::string temp_pattern{};
-    std::string temp_replace{};
-    fs::path temp_filename{};
-    std::vector<std::string> digits{};
-    bool patHasQ{pattern.find("?") != std::string::npos};
+    // Get new filenames (#^ numbers come from the position in the matches)
+    bool patHasQ{compiledPattern.hasDigits};
     bool replaceHasQ{replacement.find("?") != std::string::npos};
-    int16_t sequencePattern_idx{1};
-    
-    for ( auto pair = matchedPaths.cbegin(); pair != matchedPaths.cend(); )
+    std::vector<MenuIndex> order{};
+    order.reserve(matchedPaths.size());
+    for (auto pair : matchedPaths)
+        order.push_back(pair.first);
+
+    std::vector<fs::path> newPaths(order.size());
+    PhaseTimer planning{Phase::match, order.size()};
+    parallelFor(order.size(), [&](std::size_t pos)
     {
-        std::string originalFilename{pair->second.filename().string()};
-        temp_replace = replacement;
+        const FileRecord& record{matchedPaths.at(order[pos])};
+        std::string temp_replace{replacement};
 
         // extract digits into vector to use with ? in replacement pattern
         if (patHasQ && replaceHasQ)
+            temp_replace = replaceDigits(compiledPattern.digits(record.lowerName), temp_replace);
+        temp_replace = convertSequenceNumber(temp_replace, pos + 1, order.size());
+        newPaths[pos] = renameFile(record, compiledPattern.matchText(record.lowerName), temp_replace);
+    });
+    planning.stop();
+
+    // Check for repeat names, but not if case is different
+    std::vector<const FileRecord*> records{};
+    records.reserve(order.size());
+    for (MenuIndex idx : order)
+        records.push_back(&matchedPaths.at(idx));
+    ConflictChecker conflicts{snapshot, true};
+    std::vector<std::uint8_t> allowed{conflicts.claimAll(records, newPaths)};
+
+    // Print in menu order
+    for (std::size_t pos{}; pos < order.size(); ++pos)
+    {
+        const FileRecord& record{*records[pos]};
+        const fs::path& temp_filename{newPaths[pos]};
+
+        if ( !allowed[pos] )
         {
-            digits = extractDigits( lowercase(originalFilename), lowercase(pattern) );
-            temp_replace = replaceDigits(digits, temp_replace);
-        }
-        temp_replace = convertSequenceNumber(temp_replace, sequencePattern_idx, matchedPaths.size());
-        temp_pattern = convertPatternWithRegex(originalFilename, pattern);
-        temp_filename = renameFile(pair->second, temp_pattern, temp_replace);
-
-        // Check for repeat names, but not if case is different
-        if (
-            (fs::exists(temp_filename) || !checkMapItemUnique(matchedPaths, temp_filename)) &&
-            !(lowercase(temp_filename.filename().string()) == lowercase(originalFilename) &&
-                temp_filename.filename() != pair->second.filename())
-           )
-        {
-            redErrorMessage("Cannot rename " + originalFilename + " (Filename \"" +
-                temp_filename.filename().string() + "\" already exists.)", false);
-            matchedPaths.erase(pair++);
-            ++sequencePattern_idx;
+            printSkippedFile("Cannot rename " + record.filename + " (Filename \"" +
+                temp_filename.filename().string() + "\" already exists.)");
+            matchedPaths.erase(order[pos]);
             continue;
         }
 
-        matchedPaths[pair->first] = temp_filename;
         // Print filename and changes
-        printFileChange(filePaths[pair->first], matchedPaths[pair->first]);
-        ++pair;
-        ++sequencePattern_idx;
+        printFileChange(record.path, temp_filename);
+        matchedPaths[order[pos]] = record.renamed(temp_filename);
     }
 
     // Chance to quit
     if ( checkIfQuit(matchedPaths.size()) )
         return;
 
-    if (history.saveHistory)
-        history.update(matchedPaths, filePaths);
-
     // Rename the actual files
-    renameAndMenuUpdate(matchedPaths, filePaths);
+    renameAndMenuUpdate(matchedPaths, filePaths, history, snapshot);
 }
 
 
 
-void keywordAddAllDirs(std::set<fs::path>& directories,
-                       Filenames& filePaths, Filenames& filePaths_copy)
+void keywordAddAllDirs(std::set<fs::path>& directories, Filenames& filePaths)
 {
     std::set<fs::path> directories_temp{directories};
     int32_t count{};
-    for (auto& pair : filePaths)
+    for (auto pair : filePaths)
     {
         // Check if file is a directory and not already added
-        if (fs::is_directory(pair.second) && (directories.find(pair.second) == directories.end()))
+        if (pair.second.isDirectory && (directories.find(pair.second.path) == directories.end()))
         {
-            directories_temp.insert(pair.second);
+            directories_temp.insert(pair.second.path);
             ++count;
             setColor(Color::green);
-            std::cout << pair.second.generic_string() << '\n';
+            std::cout << pair.second.path.generic_string() << '\n';
             resetColor();
         }
     }
@@ -212,8 +228,57 @@ void keywordAddAllDirs(std::set<fs::path>& directories,
 }
 
 
-void keywordRemoveDir(std::string pattern, std::set<fs::path>& directories,
-                       Filenames& filePaths, Filenames& filePaths_copy)
+void keywordAddTree(const std::string& pattern, std::set<fs::path>& directories)
+{
+    // adir++ [levels] [-skip pattern]
+    std::size_t depth{};
+    std::string skip{};
+    for (const std::string& word : splitString(removeSpace(pattern.substr(6)), " "))
+    {
+        if (word.empty())
+            continue;
+        if (word[0] == '-')
+        {
+            skip = word.substr(1);
+            continue;
+        }
+        try
+        {
+            depth = std::stoul(word);
+        }
+        catch(const std::exception& e)
+        {
+            redErrorMessage("Error: \"" + word + "\" is not a number of levels.");
+            return;
+        }
+    }
+
+    std::set<fs::path> found{};
+    for (auto& dir : getSubdirectories(directories, depth, skip))
+    {
+        if (!directories.contains(dir))
+            found.insert(dir);
+    }
+    if (found.empty())
+    {
+        redErrorMessage("No new directories found.");
+        return;
+    }
+
+    setColor(Color::green);
+    for (auto& dir : found)
+        std::cout << dir.generic_string() << '\n';
+    setColor(Color::blue);
+    std::cout << '\n' << found.size() << " directories found.\n";
+    resetColor();
+
+    if (readInput("Press ENTER to add these directories. (q to quit.)\n> ") != "")
+        return;
+    directories.insert(found.begin(), found.end());
+}
+
+
+void keywordRemoveDir(std::string pattern, std::set<fs::path>& directories)
 {
     std::string query{};
     std::string pattern_end{removeSpace(pattern.substr(5))};
@@ -254,7 +319,6 @@ void keywordRemoveDir(std::string pattern, std::set<fs::path>& directories,
 
 
 void keywordChangeDir(const std::string& pattern, std::set<fs::path>& directories, 
-                      Filenames& filePaths, Filenames& filePaths_copy, 
                       const bool add = false)
 {
     std::string newDir{};
@@ -299,25 +363,25 @@ void keywordChangeDir(const std::string& pattern, std::set<fs::path>& directorie
 
 bool removeByFilename(std::string filename, 
                       Filenames& filePaths,
-                      Filenames& filePaths_copy)
+                      const Filenames& filePaths_copy)
 {
     bool fileFound{};
     filename = removeSpace(filename);
     setColor(Color::green);
-    for (auto& pair : filePaths_copy)
+    for (auto pair : filePaths_copy)
     {
-        if (filename == pair.second.filename().string())
+        if (filename == pair.second.filename)
         {
             if (filePaths.contains(pair.first))
             {
-                std::cout << "File removed: " << pair.second.filename().string() << '\n';
+                std::cout << "File removed: " << pair.second.filename << '\n';
                 filePaths.erase(pair.first);
                 fileFound = true;
             }
             else
             {
-                filePaths[pair.first] = filePaths_copy[pair.first];
-                std::cout << "File restored: " << pair.second.filename().string() << '\n';
+                filePaths[pair.first] = pair.second;
+                std::cout << "File restored: " << pair.second.filename << '\n';
                 fileFound = true;
             }
         }
@@ -329,7 +393,7 @@ bool removeByFilename(std::string filename,
 
 void keywordRemoveFilename(const std::string& pattern, 
                            Filenames& filePaths,
-                           Filenames& filePaths_copy)
+                           const Filenames& filePaths_copy)
 {
     try
     {
@@ -343,7 +407,7 @@ void keywordRemoveFilename(const std::string& pattern,
         {
             int32_t index{ stoi(index_string) };
 
-            if ( index < 0 || index > (filePaths_copy.size() - 1) )
+            if ( !filePaths_copy.contains(index) )
             {
                 redErrorMessage("Index " + std::to_string(index) + " is out of bounds.", false);
                 continue;
@@ -352,15 +416,15 @@ void keywordRemoveFilename(const std::string& pattern,
             if (filePaths.contains(index))
             {
                 setColor(Color::green);
-                std::cout << "File removed: " << filePaths_copy[index].filename().string() << '\n';
+                std::cout << "File removed: " << filePaths_copy.at(index).filename << '\n';
                 filePaths.erase(index);
                 resetColor();
             }
             else
             {
-                filePaths[index] = filePaths_copy[index];
+                filePaths[index] = filePaths_copy.at(index);
                 setColor(Color::green);
-                std::cout << "File restored: " << filePaths_copy[index].filename().string() << '\n';
+                std::cout << "File restored: " << filePaths_copy.at(index).filename << '\n';
                 resetColor();
             }
         }
@@ -374,13 +438,13 @@ void keywordRemoveFilename(const std::string& pattern,
 
 bool KeepByFilename(std::string filename, 
                       Filenames& filePaths,
-                      Filenames& filePaths_copy)
+                      const Filenames& filePaths_copy)
 {
     bool fileFound{};
     filename = removeSpace(filename);
-    for (auto& pair : filePaths_copy)
+    for (auto pair : filePaths_copy)
     {
-        if (filename == pair.second.filename().string())
+        if (filename == pair.second.filename)
         {
             filePaths[pair.first] = pair.second;
             fileFound = true;
@@ -393,7 +457,7 @@ bool KeepByFilename(std::string filename,
 
 void keywordRemoveAllFilenames(const std::string& pattern, 
                            Filenames& filePaths,
-                           Filenames& filePaths_copy)
+                           const Filenames& filePaths_copy)
 {
     filePaths.clear();
     try
@@ -407,12 +471,12 @@ void keywordRemoveAllFilenames(const std::string& pattern,
         std::vector<std::string> index_strs{ splitString(subPat, ",") };
         convertRangeDashes(index_strs);
 
-        std::vector<std::int16_t> indexes{};
+        std::vector<MenuIndex> indexes{};
         for (std::string index_string: index_strs)
         {
             int32_t idx{ stoi(index_string) };
 
-            if ( idx < 0 || idx > (filePaths_copy.size() - 1) )
+            if ( !filePaths_copy.contains(idx) )
             {
                 redErrorMessage("Index " + std::to_string(idx) + " is out of bounds.", false);
                 continue;
@@ -422,13 +486,13 @@ void keywordRemoveAllFilenames(const std::string& pattern,
         }
 
 
-        for (std::int16_t index: indexes)
+        for (MenuIndex index: indexes)
         {
             if (filePaths_copy.contains(index))
             {
                 setColor(Color::green);
-                std::cout << "File kept: " << filePaths_copy[index].filename().string() << '\n';
-                filePaths[index] = filePaths_copy[index];
+                std::cout << "File kept: " << filePaths_copy.at(index).filename << '\n';
+                filePaths[index] = filePaths_copy.at(index);
                 resetColor();
             }
         }
@@ -441,46 +505,45 @@ void keywordRemoveAllFilenames(const std::string& pattern,
 }
 
 
-void keywordRemoveDots(Filenames& filePaths, HistoryData& history)
+void keywordRemoveDots(Filenames& filePaths, DirectorySnapshot& snapshot, 
+                       HistoryData& history)
 {
     Filenames matchedPaths{};
-    fs::path new_path{};
-    std::string old_filename{};
+    std::vector<MenuIndex> order{};
+    std::vector<const FileRecord*> records{};
+    std::vector<fs::path> newPaths{};
     std::string new_filename{};
-    bool dotAtStart{};
     std::cout << '\n';
 
-    // Get matches and print
-    for (auto& pair: filePaths)
+    // Get matches
+    PhaseTimer matching{Phase::match, filePaths.size()};
+    for (auto pair : filePaths)
     {
-        new_path = pair.second;
-        dotAtStart = false;
-        
-        // Remove suffix, and extension from path if not folder
-        removeDotEnds(new_path, dotAtStart);
-
-        // Check for matches
-        if ( new_path.filename().string().find(".") == std::string::npos )
+        new_filename = replaceDots(pair.second);
+        if ( new_filename.empty() )
             continue;
 
-        // Remove dots from path filename
-        new_path.replace_filename(strReplaceAll(new_path.filename().string(), ".", " "));
-
-        // Restore extension or suffix to path
-        restoreDotEnds(new_path, pair.second, dotAtStart);
-
-        new_filename = new_path.filename().string();
-        old_filename = pair.second.filename().string();
+        order.push_back(pair.first);
+        records.push_back(&pair.second);
+        newPaths.push_back(pair.second.path.parent_path() / new_filename);
+    }
+    matching.stop();
 
-        // Check for naming conflicts
-        if (fs::exists(new_path) || !checkMapItemUnique(matchedPaths, new_path))
+    // Check for naming conflicts, then print
+    ConflictChecker conflicts{snapshot};
+    std::vector<std::uint8_t> allowed{conflicts.claimAll(records, newPaths)};
+    for (std::size_t pos{}; pos < order.size(); ++pos)
+    {
+        const std::string& old_filename{records[pos]->filename};
+        new_filename = newPaths[pos].filename().string();
+        if ( !allowed[pos] )
             {
-                redErrorMessage("Cannot rename \"" + old_filename + "\" (Filename \"" + 
-                                new_filename + "\" already exists.)\n", false);
+                printSkippedFile("Cannot rename \"" + old_filename + "\" (Filename \"" + 
+                                new_filename + "\" already exists.)\n");
                 continue;
             }
 
-        matchedPaths[pair.first] = new_path;
+        matchedPaths[order[pos]] = records[pos]->renamed(newPaths[pos]);
         printFileChange(old_filename, new_filename);
     }
 
@@ -492,26 +555,22 @@ void keywordRemoveDots(Filenames& filePaths, HistoryData& history)
     if ( checkIfQuit(matchedPaths.size()) )
         return;
 
-    if (history.saveHistory)
-        history.update(matchedPaths, filePaths);
-
     // Rename the actual files and update menu
-    renameAndMenuUpdate(matchedPaths, filePaths);
+    renameAndMenuUpdate(matchedPaths, filePaths, history, snapshot);
 }
 
 
 
-void keywordBetween(Filenames& filePaths, HistoryData& history, bool plus)
+void keywordBetween(Filenames& filePaths, DirectorySnapshot& snapshot, 
+                    HistoryData& history, bool plus)
 {
     std::string lpat{};
     std::string rpat{};
     std::string replacement{};
     fs::path fullPath{};
     
-    std::cout << "Enter left pattern: ";
-    getline(std::cin, lpat);
-    std::cout << "Enter right pattern: ";
-    getline(std::cin, rpat);
+    lpat = readInput("Enter left pattern: ");
+    rpat = readInput("Enter right pattern: ");
 
     // Check if index number can be converted
     std::int16_t lIndexCheck{getIndex(lpat)};
@@ -529,15 +588,24 @@ void keywordBetween(Filenames& filePaths, HistoryData& history, bool plus)
         rpat = "#end";
 
     std::cout << '\n';
+    const Pattern lpattern{lpat};
+    const Pattern rpattern{rpat};
+    std::vector<std::pair<MenuIndex, BetweenMatch>> matches{};
+    std::vector<MenuIndex> matchedRows{};      // Preview rows
     int32_t matchNum{};
-    for (auto& pair : filePaths)
+    PhaseTimer matching{Phase::match, filePaths.size()};
+    for (auto pair : filePaths)
     {
-        if ( checkBetweenMatches(pair.second, lpat, rpat) )
+        BetweenMatch match{matchBetween(pair.second, lpattern, rpattern, plus)};
+        if ( match.matched )
         {
-            betweenPrintFilenameWithColor(pair.second, lpat, rpat, plus);
+            matchedRows.push_back(pair.first);
             ++matchNum;
         }
+        if ( match.renamable )
+            matches.push_back({pair.first, std::move(match)});
     }
+    matching.stop();
 
     // Check if matches
     if (!matchNum)
@@ -546,90 +614,132 @@ void keywordBetween(Filenames& filePaths, HistoryData& history, bool plus)
         return;
     }
 
-    std::cout << "\nEnter replacement pattern (or q to quit):\n> ";
-    getline(std::cin, replacement);
+    // Only the files on the preview page are matched again for highlighting
+    Pager pager{matchedRows.size()};
+    bool firstPage{true};
+    do
+    {
+        PhaseTimer previewing{Phase::preview, pager.last() - pager.first()};
+        if (!firstPage)
+            screen << '\n';
+        firstPage = false;
+        for (std::size_t row{pager.first()}; row < pager.last(); ++row)
+            betweenPrintFilenameWithColor(matchBetween(filePaths.at(matchedRows[row]),
+                                                       lpattern, rpattern, plus));
+        printPageSummary(pager, '\n' + std::to_string(matchNum) + " of " +
+                                std::to_string(filePaths.size()) + " filenames match.");
+        previewing.stop();
+        screen.flush();
+        replacement = readInput("\nEnter replacement pattern (or q to quit):\n> ");
+    } while (pager.command(replacement));
 
     if (replacement == "q")
         return;
     
     std::cout << '\n';
+    // Get new filenames (#^ numbers come from the position in the matches)
+    std::vector<fs::path> newPaths(matches.size());
+    PhaseTimer planning{Phase::match, matches.size()};
+    parallelFor(matches.size(), [&](std::size_t pos)
+    {
+        std::string temp_replacement{replacement};
+        temp_replacement = convertSequenceNumber(temp_replacement, pos + 1, matchNum);
+        newPaths[pos] = getBetweenFilename(matches[pos].second, temp_replacement);
+    });
+    planning.stop();
+
+    // Files keeping their name stay in the batch so nothing else can take it
+    std::vector<const FileRecord*> records{};
+    records.reserve(matches.size());
+    for (auto& [idx, match]: matches)
+        records.push_back(&filePaths.at(idx));
+    ConflictChecker conflicts{snapshot};
+    std::vector<std::uint8_t> allowed{conflicts.claimAll(records, newPaths)};
+
     // Get matched filenames
-    int16_t sequencePattern_idx{1};
     Filenames matchedPaths{};
-    std::string temp_replacement{};
-    for (auto& pair: filePaths)
+    for (std::size_t pos{}; pos < matches.size(); ++pos)
     {
-        fs::path path{pair.second};
-        int16_t idx{pair.first};
-
-        temp_replacement = convertSequenceNumber(replacement, sequencePattern_idx, matchNum);
-        fullPath = getBetweenFilename(path, lpat, rpat, temp_replacement, plus);
-
-        if (fullPath == "")
-            continue;  // Skip if no match
+        MenuIndex idx{matches[pos].first};
+        const fs::path& path{matches[pos].second.path};
+        fullPath = newPaths[pos];
 
         // Make sure new filename is different
         if (fullPath == path)
-        {
-            ++sequencePattern_idx;
             continue;
-        }
 
         // Make sure multiple files are not named the same name:
-        if (fs::exists(fullPath) || !checkMapItemUnique(matchedPaths, fullPath))
+        if ( !allowed[pos] )
         {
-            redErrorMessage("Cannot rename " + path.filename().string() + " (Filename " + 
-                            fullPath.filename().string() + " already exists.)", false);
-            ++sequencePattern_idx;
+            printSkippedFile("Cannot rename " + path.filename().string() + " (Filename " + 
+                            fullPath.filename().string() + " already exists.)");
             continue;
         }
 
-        matchedPaths[idx] = fullPath;
+        matchedPaths[idx] = filePaths[idx].renamed(fullPath);
         printFileChange(path, fullPath);
-        ++sequencePattern_idx;
     }
 
     // Print number of matches then ask to quit or continue
     if (checkIfQuit(matchedPaths.size()) )
         return;
 
-    if (history.saveHistory)
-        history.update(matchedPaths, filePaths);
-
     //Rename and print
-    renameAndMenuUpdate(matchedPaths, filePaths);
+    renameAndMenuUpdate(matchedPaths, filePaths, history, snapshot);
 }
 
 
 
 void keywordCapOrLower(Filenames& filePaths, std::string_view pattern,
-                       HistoryData& history)
+                       DirectorySnapshot& snapshot, HistoryData& history)
 {
     Filenames matchedPaths{};
     fs::path path{};
     std::string filename{};
     std::cout << '\n';
 
-    // Get matches and print
-    for (auto& pair: filePaths)
+    // Get matches, then check and print them
+    std::vector<MenuIndex> order{};
+    std::vector<const FileRecord*> records{};
+    std::vector<fs::path> newPaths{};
+    PhaseTimer matching{Phase::match, filePaths.size()};
+    for (auto pair : filePaths)
     {
-        fs::path path = pair.second;
-        std::string newFilename = path.filename().string();
+        const fs::path& path = pair.second.path;
+        std::string newFilename{};
 
         if (pattern == "!lower")
-            toLowercase(newFilename);
+            newFilename = pair.second.lowerName;
         else if (pattern == "!cap")
+        {
+            newFilename = pair.second.filename;
             capitalize(newFilename);
+        }
 
         // Check if a match
-        if(path.filename() != newFilename)
+        if(pair.second.filename != newFilename)
         {
-            fs::path fullPath{path.parent_path() /= newFilename};
-            matchedPaths[pair.first] = fullPath;
-            // Print
-            printFileChange(path, fullPath);
+            order.push_back(pair.first);
+            records.push_back(&filePaths.at(pair.first));
+            newPaths.push_back(path.parent_path() / newFilename);
         }
     }
+    matching.stop();
+
+    // Another file may already have the new name (case-sensitive systems)
+    ConflictChecker conflicts{snapshot, true};
+    std::vector<std::uint8_t> allowed{conflicts.claimAll(records, newPaths)};
+    for (std::size_t pos{}; pos < order.size(); ++pos)
+    {
+        if ( !allowed[pos] )
+        {
+            printSkippedFile("Cannot rename " + records[pos]->filename + " (Filename \"" +
+                            newPaths[pos].filename().string() + "\" already exists.)");
+            continue;
+        }
+        matchedPaths[order[pos]] = records[pos]->renamed(newPaths[pos]);
+        printFileChange(records[pos]->path, newPaths[pos]);
+    }
 
     if ( !checkForMatches(matchedPaths) )
         return;
@@ -637,11 +747,8 @@ void keywordCapOrLower(Filenames& filePaths, std::string_view pattern,
     if ( checkIfQuit(matchedPaths.size()) )
         return;
 
-    if (history.saveHistory)
-        history.update(matchedPaths, filePaths);
-
     // Rename files and update menu
-    renameAndMenuUpdate(matchedPaths, filePaths);
+    renameAndMenuUpdate(matchedPaths, filePaths, history, snapshot);
 }
 
 
@@ -658,95 +765,150 @@ void keywordPWD(const std::set<fs::path>& directories)
 
 
 
-void keywordSeries(Filenames& filePaths, HistoryData& history)
+void keywordChain(const std::string& pattern, Filenames& filePaths,
+                  DirectorySnapshot& snapshot, HistoryData& history)
 {
-// Dots code start (edited):
-    Filenames matchedPaths{filePaths};
-    fs::path new_path{};
-    std::string old_filename{};
-    std::string new_filename{};
-    bool dotAtStart{};
-    std::cout << '\n';
-    // Get matches and print
-    for (auto& pair: filePaths)
+    const RenameChain chain{pattern};
+    if (!chain.error.empty())
     {
-        new_path = pair.second;
-        dotAtStart = false;
-        
-        // Remove suffix, and extension from path if not folder
-        removeDotEnds(new_path, dotAtStart);
+        redErrorMessage(chain.error);
+        return;
+    }
+
+    std::vector<MenuIndex> order{};
+    std::vector<FileRecord> oldRecords{};
+    for (auto pair : filePaths)
+    {
+        order.push_back(pair.first);
+        oldRecords.push_back(pair.second);
+    }
+    std::vector<FileRecord> newRecords{chain.apply(oldRecords)};
+
+    // Only the final names are checked, changes of case are never a conflict
+    std::vector<std::size_t> changed{};
+    std::vector<const FileRecord*> records{};
+    std::vector<fs::path> newPaths{};
+    for (std::size_t pos{}; pos < order.size(); ++pos)
+    {
+        if (newRecords[pos].path == oldRecords[pos].path)
+            continue;
+        changed.push_back(pos);
+        records.push_back(&oldRecords[pos]);
+        newPaths.push_back(newRecords[pos].path);
+    }
+    ConflictChecker conflicts{snapshot, true};
+    std::vector<std::uint8_t> allowed{conflicts.claimAll(records, newPaths)};
 
-        // Check for matches
-        if ( new_path.filename().string().find(".") == std::string::npos )
+    std::cout << '\n';
+    Filenames matchedPaths{};
+    for (std::size_t num{}; num < changed.size(); ++num)
+    {
+        std::size_t pos{changed[num]};
+        if ( !allowed[num] )
+        {
+            printSkippedFile("Cannot rename " + oldRecords[pos].filename + " (Filename \"" +
+                            newRecords[pos].filename + "\" already exists.)");
             continue;
+        }
+        matchedPaths[order[pos]] = newRecords[pos];
+        printFileChange(oldRecords[pos].path, newRecords[pos].path);
+    }
+
+    if ( checkIfQuit(matchedPaths.size()) )
+        return;
+
+    // One rename per file, whatever the number of steps
+    renameAndMenuUpdate(matchedPaths, filePaths, history, snapshot);
+}
+
 
-        // Remove dots from path filename
-        new_path.replace_filename(strReplaceAll(new_path.filename().string(), ".", " "));
 
-        // Restore extension or suffix to path
-        restoreDotEnds(new_path, pair.second, dotAtStart);
+void keywordSeries(Filenames& filePaths, DirectorySnapshot& snapshot, 
+                   HistoryData& history)
+{
+// Dots code start (edited):
+    Filenames matchedPaths{filePaths};
+    ConflictChecker conflicts{snapshot};
+    std::vector<MenuIndex> order{};
+    order.reserve(filePaths.size());
+    for (auto pair : filePaths)
+        order.push_back(pair.first);
+
+    // Get new filenames, empty if no dots
+    std::vector<std::string> dotNames(order.size());
+    PhaseTimer matching{Phase::match, order.size()};
+    parallelFor(order.size(), [&](std::size_t pos)
+    {
+        dotNames[pos] = replaceDots(filePaths.at(order[pos]));
+    });
+    matching.stop();
+
+    std::cout << '\n';
+    // Check for naming conflicts
+    std::vector<std::size_t> dotted{};
+    std::vector<const FileRecord*> records{};
+    std::vector<fs::path> newPaths{};
+    for (std::size_t pos{}; pos < order.size(); ++pos)
+    {
+        if (dotNames[pos].empty())
+            continue;
+        dotted.push_back(pos);
+        records.push_back(&filePaths.at(order[pos]));
+        newPaths.push_back(records.back()->path.parent_path() / dotNames[pos]);
+    }
+    std::vector<std::uint8_t> allowed{conflicts.claimAll(records, newPaths)};
 
+    for (std::size_t num{}; num < dotted.size(); ++num)
+    {
         // For code readability
-        old_filename = pair.second.filename().string();
-        new_filename = new_path.filename().string();
+        std::size_t pos{dotted[num]};
+        const FileRecord& record{*records[num]};
+        const std::string& new_filename{dotNames[pos]};
+        const fs::path& new_path{newPaths[num]};
 
         // Check for naming conflict
-        if (fs::exists(new_path) || !checkMapItemUnique(matchedPaths, new_path))
+        if ( !allowed[num] )
             {
-                redErrorMessage("Cannot rename \"" + old_filename + "\" (Filename \"" + new_filename + "\" already exists.)\n", false);
+                printSkippedFile("Cannot rename \"" + record.filename + "\" (Filename \"" + new_filename + "\" already exists.)\n");
                 continue;
             }
 
-        matchedPaths[pair.first] = new_path;
+        matchedPaths[order[pos]] = record.renamed(new_path);
     }
 // End of dots code
-// Start cap code (edited)
-    for (auto& pair: matchedPaths)
+// Start cap code (edited), then between code (edited and regex)
+    const std::regex pattern{"[Ss][0-9][0-9][Ee][0-9][0-9]"};
+    const std::string rpat{"#end"};
+    order.clear();
+    for (auto pair : matchedPaths)
+        order.push_back(pair.first);
+
+    // Files without s01e01 are left without a record
+    std::vector<FileRecord> lowered(order.size());
+    std::vector<fs::path> seriesPaths(order.size());
+    std::vector<std::uint8_t> found(order.size());
+    PhaseTimer planning{Phase::match, order.size()};
+    parallelFor(order.size(), [&](std::size_t pos)
     {
-        fs::path path = pair.second;
-        std::string newFilename = path.filename().string();
+        FileRecord record{matchedPaths.at(order[pos])};
+        std::string new_filename{record.filename};
 
-        capitalize(newFilename);
+        capitalize(new_filename);
+        if (record.filename != new_filename)
+            record = record.renamed(record.path.parent_path() / new_filename);
 
-        // Check if a match
-        if(path.filename() != newFilename)
-        {
-            fs::path fullPath{path.parent_path() /= newFilename};
-            matchedPaths[pair.first] = fullPath;
-        }
-    }
-// Begin between code (edited and regex)
-    std::regex pattern{"[Ss][0-9][0-9][Ee][0-9][0-9]"};
-    std::smatch sm;
-    std::string lpat{};
-    std::string rpat{"#end"};
-    std::string replacement{};
-    fs::path fullPath{};
-    
-    // Get matched filenames
-    Filenames renamed_temp{};      // To check for naming conflicts
-    for (auto pair = matchedPaths.cbegin(); pair != matchedPaths.cend(); )
-    {
-        fs::path path{pair->second};
-        int16_t idx{pair->first};
-        new_filename = path.filename().string();
+        std::smatch sm;
         std::regex_search(new_filename, sm, pattern);
-        if (sm[0] != "")
-        {
-            lpat = sm[0];
+        if (sm[0] == "")
+            return;
+        std::string lpat{sm[0]};
 
-            // make s01e01 lowercase
-            new_filename.replace(sm.position(0), 1, "s");
-            new_filename.replace(sm.position(0) + 3, 1, "e");
-        }
-        else
-        {
-            matchedPaths.erase(pair++);
-            continue;
-        }
+        // make s01e01 lowercase
+        new_filename.replace(sm.position(0), 1, "s");
+        new_filename.replace(sm.position(0) + 3, 1, "e");
 
         // Add resolution size to end of filename (if found)
-        fs::path newPath{new_filename};
+        std::string replacement{};
         if (new_filename.find("360p") != std::string::npos)
             replacement = " [360p]";
         else if (new_filename.find("480p") != std::string::npos)
@@ -756,47 +918,73 @@ void keywordSeries(Filenames& filePaths, HistoryData& history)
         else if (new_filename.find("1080p") != std::string::npos)
             replacement = " [1080p]";
 
-        path.replace_filename(newPath);
-        matchedPaths[idx].replace_filename(newPath);
+        fs::path path{record.path};
+        path.replace_filename(new_filename);
+        lowered[pos] = record.renamed(path);
+        seriesPaths[pos] = getBetweenFilename(lowered[pos], lpat, rpat, replacement, false);
+        found[pos] = true;
+    });
+    planning.stop();
+
+    // Check for naming conflicts. Files keeping their name stay in the batch
+    // so nothing else can take it
+    conflicts.resetClaims();
+    records.clear();
+    newPaths.clear();
+    for (std::size_t pos{}; pos < order.size(); ++pos)
+    {
+        records.push_back(&filePaths.at(order[pos]));
+        if (!found[pos])
+            newPaths.push_back(records.back()->path);
+        else if (seriesPaths[pos] == "")
+            newPaths.push_back(lowered[pos].path);
+        else
+            newPaths.push_back(seriesPaths[pos]);
+    }
+    allowed = conflicts.claimAll(records, newPaths);
 
-// ============================
-        fullPath = getBetweenFilename(path, lpat, rpat, replacement, false);
-        replacement = "";
-        // Skip if no match and make sure new filename is different
-        if (fullPath == "" || fullPath == pair->second)
+    // Get matched filenames
+    for (std::size_t pos{}; pos < order.size(); ++pos)
+    {
+        MenuIndex idx{order[pos]};
+        if (!found[pos])
         {
-            ++pair;
+            matchedPaths.erase(idx);
             continue;
         }
+        matchedPaths[idx] = lowered[pos];
+
+        // Skip if no match and make sure new filename is different
+        const fs::path& fullPath{seriesPaths[pos]};
+        if (fullPath == "" || fullPath == lowered[pos].path)
+            continue;
 
         // Make sure multiple files are not named the same name:
-        if (fs::exists(fullPath) || !checkMapItemUnique(renamed_temp, fullPath))
+        if ( !allowed[pos] )
         {
-            redErrorMessage("Cannot rename " + path.filename().string() + " (Filename " + fullPath.filename().string() + " already exists.)", false);
-            matchedPaths.erase(pair++);
+            printSkippedFile("Cannot rename " + lowered[pos].filename + " (Filename " + fullPath.filename().string() + " already exists.)");
+            matchedPaths.erase(idx);
             continue;
         }
 
-        renamed_temp[idx] = fullPath;
-        matchedPaths[idx] = fullPath;
-        ++pair;
+        matchedPaths[idx] = lowered[pos].renamed(fullPath);
     }
 // End between code
     // Print
     std::cout << '\n';
-    int16_t idx{};
+    MenuIndex idx{};
     for (auto pair = matchedPaths.cbegin(); pair != matchedPaths.cend(); )
     {
         idx = pair->first;
-        if (filePaths[idx] == matchedPaths[idx])
+        if (filePaths[idx].path == matchedPaths[idx].path)
         {
-            redErrorMessage(filePaths[idx].filename().string() + " is already named properly.", false);
+            printSkippedFile(filePaths[idx].filename + " is already named properly.");
             matchedPaths.erase(pair++);
             continue;
         }
         else
         {
-            printFileChange(filePaths[idx], matchedPaths[idx]);
+            printFileChange(filePaths[idx].path, matchedPaths[idx].path);
             ++pair;
         }
     }
@@ -811,11 +999,8 @@ void keywordSeries(Filenames& filePaths, HistoryData& history)
     if (checkIfQuit(matchedPaths.size()) )
         return;
 
-    if (history.saveHistory)
-        history.update(matchedPaths, filePaths);
-
     // Rename files and update menu
-    renameAndMenuUpdate(matchedPaths, filePaths);
+    renameAndMenuUpdate(matchedPaths, filePaths, history, snapshot);
 }
 
 
@@ -835,7 +1020,7 @@ void keywordPrintToFile(Filenames& filePaths, bool& showNums, std::set<fs::path>
 // Used with keywordRenameSubs
 fs::path getFirstFolder()
 {
-    for (const auto& dir: fs::directory_iterator(".\\"))
+    for (const auto& dir: fs::directory_iterator("."))
     {
         if (dir.is_directory())
             return dir;
@@ -846,7 +1031,7 @@ fs::path getFirstFolder()
 }
 
 
-void keywordRenameSubs(Filenames& filePaths, HistoryData& history)
+void keywordRenameSubs(Filenames& filePaths, DirectorySnapshot& snapshot, HistoryData& history)
 {
     fs::path sub_directory{getFirstFolder()};
 
@@ -885,7 +1070,7 @@ void keywordRenameSubs(Filenames& filePaths, HistoryData& history)
     for (size_t idx{}; idx < size_copy; ++idx )
     {
         // remove filenames that were unchanged
-        if (subtitlePaths[idx] == newSubPaths[idx])
+        if (subtitlePaths[idx].path == newSubPaths[idx].path)
         {
             subtitlePaths.erase(idx);
             newSubPaths.erase(idx);
@@ -893,7 +1078,7 @@ void keywordRenameSubs(Filenames& filePaths, HistoryData& history)
             continue;
         }
 
-        printFileChange(subtitlePaths[idx], newSubPaths[idx]);
+        printFileChange(subtitlePaths[idx].path, newSubPaths[idx].path);
     }
     
     // Check if there are any filenames to change
@@ -907,11 +1092,8 @@ void keywordRenameSubs(Filenames& filePaths, HistoryData& history)
     if (checkIfQuit(size))
         return;
 
-    if (history.saveHistory)
-        history.update(newSubPaths, subtitlePaths);
-
     // Rename files and update menu
-    renameAndMenuUpdate(newSubPaths, subtitlePaths);
+    renameAndMenuUpdate(newSubPaths, subtitlePaths, history, snapshot);
 
 }
 
@@ -923,9 +1105,9 @@ void keywordRemoveDirectories(Filenames& filePaths, bool remove)
     bool itemRemoved{};
     for (auto pair = filePaths.cbegin(); pair != filePaths.cend(); )
     {
-        if ( fs::is_directory(pair->second) == remove)
+        if ( pair->second.isDirectory == remove)
         {
-            std::cout << "Removed: " << pair->second << '\n';
+            std::cout << "Removed: " << pair->second.path << '\n';
             filePaths.erase(pair++);
             itemRemoved = true;
         }
@@ -943,8 +1125,11 @@ void keywordRemoveDirectories(Filenames& filePaths, bool remove)
 void keywordWordCount(Filenames& filePaths)
 {
     std::vector<fs::path> vectorPaths{};
-    for (auto& p: filePaths)
-        vectorPaths.push_back(p.second);
+    for (auto p : filePaths)
+    {
+        if (!p.second.isDirectory)
+            vectorPaths.push_back(p.second.path);
+    }
 
     TextCount wordCount(vectorPaths);
     wordCount.printInfo();
@@ -955,20 +1140,27 @@ void keywordWordCount(Filenames& filePaths)
 
 
 
-void keywordHistory(HistoryData& history, Filenames& filePaths)
+void keywordHistory(HistoryData& history, Filenames& filePaths, DirectorySnapshot& snapshot)
 {
-    if (history.historyData.empty())
+    if (history.empty())
     {
         redErrorMessage("There is no history.");
         return;
     }
 
-    history.print();
-    std::cout << "\nEnter an index number to undo rename. (Green examples can revert, red don't currently exist.)\n" 
-                 "Type 'clear' to erase history.\n" 
-                 "Or press ENTER to return to menu:\n> ";
+    // A page of entries at a time: history has no size limit
+    Pager pager{history.size()};
     std::string query{};
-    std::getline(std::cin, query);
+    do
+    {
+        history.print(pager);
+        printPageSummary(pager, "\n" + std::to_string(pager.total) + " history entries.");
+        screen.flush();
+        std::cout << "\nEnter index numbers (#,#-#) to undo renames. (Green examples can revert, red don't currently exist.)\n" 
+                     "Type 'clear' to erase history.\n" 
+                     "Or press ENTER to return to menu:\n> ";
+        std::getline(std::cin, query);
+    } while (pager.command(query));
 
     if (query == "q" || query == "")
         return;
@@ -978,29 +1170,90 @@ void keywordHistory(HistoryData& history, Filenames& filePaths)
         return;
     }
 
-    std::int32_t index{};
+    std::vector<std::size_t> indexes{};
     try
     {
-        index = stoi(query);
-        if (index >= history.historyData.size() || index < 0)
+        std::vector<std::string> index_strs{ splitString(query, ",") };
+        convertRangeDashes(index_strs);
+        for (auto& index_str : index_strs)
         {
-            const std::exception e{};
-            throw e;
+            std::int32_t index{ stoi(index_str) };
+            if (index < 0 || static_cast<std::size_t>(index) >= history.size())
+            {
+                const std::exception e{};
+                throw e;
+            }
+            indexes.push_back(static_cast<std::size_t>(index));
         }
     }
     catch(const std::exception& e)
     {
-        redErrorMessage("ERROR: Index number 0-" + std::to_string(history.historyData.size() - 1) + " required.");
+        redErrorMessage("ERROR: Index number 0-" + std::to_string(history.size() - 1) + " required.");
         return;
     }
-    fs::path renamedFile{history.historyData[index].begin()->second};
-    if (!fs::exists(renamedFile))
+
+    // Every file of the entries is checked before anything is renamed
+    undoRename(history, indexes, filePaths, snapshot);
+}
+
+
+
+void keywordTrace(const std::string& pattern, HistoryData& history, const Filenames& filePaths)
+{
+    std::string name{removeSpace(pattern.substr(6))};
+    if (name == "")
+    {
+        std::cout << "Enter a filename or path to trace (or q to quit):\n> ";
+        getline(std::cin, name);
+        if (name == "q" || name == "")
+            return;
+    }
+
+    // The name can be a path, a menu filename, or a filename from history
+    std::set<fs::path> paths{};
+    if (fs::path{name}.has_parent_path())
+        paths.insert(fs::absolute(name));
+    for (auto pair : filePaths)
+    {
+        if (pair.second.filename == name)
+            paths.insert(pair.second.path);
+    }
+    for (auto& path : history.pathsNamed(name))
+        paths.insert(path);
+
+    // Print each chain once
+    std::set<std::vector<std::size_t>> printed{};
+    for (auto& path : paths)
+    {
+        std::vector<HistoryLog::Rename> chain{history.trace(path)};
+        std::vector<std::size_t> indexes{};
+        for (auto& rename : chain)
+            indexes.push_back(rename.index);
+        if (chain.empty() || !printed.insert(indexes).second)
+            continue;
+
+        setColor(Color::blue);
+        std::cout << "\nDirectory: " << chain.front().oldPath.parent_path().generic_string() << '\n';
+        resetColor();
+        for (auto& rename : chain)
+        {
+            std::cout << rename.index << ". ";
+            setColor(Color::green);
+            std::cout << rename.oldPath.filename().string();
+            resetColor();
+            std::cout << " --> ";
+            setColor(Color::green);
+            std::cout << rename.newPath.filename().string() << '\n';
+            resetColor();
+        }
+    }
+
+    if (printed.empty())
     {
-        redErrorMessage("Cannot undo because \"" + renamedFile.filename().string() + "\" has since been changed.");
+        redErrorMessage("No rename history for \"" + name + "\".");
         return;
     }
-    
-    undoRename(history, index, filePaths);
+    printPause();
 }
 
 
@@ -1034,14 +1287,15 @@ void keywordFind(std::string& pat, Filenames& filePaths, bool remove)
     }
 
     std::string name{};
+    const Pattern compiledPattern{pattern};
     Filenames filePaths_temp{filePaths};
     std::string messageFilesRemoved{};
     bool matchFound{};
     for (auto pair = filePaths_temp.cbegin(); pair != filePaths_temp.cend(); )
     {
-        name = lowercase(pair->second.filename().string());
-        pattern_temp = convertPatternWithRegex(name, pattern);
-        if (name.find(lowercase(pattern_temp)) == std::string::npos)
+        name = pair->second.lowerName;
+        pattern_temp = compiledPattern.matchText(name);
+        if (name.find(pattern_temp) == std::string::npos)
         {
             if (!remove)
             {
@@ -1086,4 +1340,45 @@ void keywordFind(std::string& pat, Filenames& filePaths, bool remove)
     std::cout << messageFilesRemoved;
     resetColor();
     filePaths = filePaths_temp;
-}
\ No newline at end of file
+}
+
+
+
+void reloadMenu(Filenames& filePaths, DirectorySnapshot& snapshot,
+                const std::set<fs::path>& directories)
+{
+    snapshot.reload(directories);
+    filePaths = snapshot.files;
+}
+
+
+
+void keywordStats(const std::string& pattern)
+{
+    std::string option{removeSpace(pattern.substr(6))};
+    if (option.rfind("json", 0) != 0)
+    {
+        setColor(Color::blue);
+        std::cout << '\n' << stats.table();
+        resetColor();
+        printPause();
+        return;
+    }
+
+    std::string filename{removeSpace(option.substr(4))};
+    if (filename.empty())
+    {
+        std::cout << '\n' << stats.json();
+        printPause();
+        return;
+    }
+    std::ofstream file{filename};
+    if (!(file << stats.json()))
+    {
+        redErrorMessage("Cannot write " + filename);
+        return;
+    }
+    setColor(Color::green);
+    std::cout << "\nStats saved to " << filename << '\n';
+    resetColor();
+}
@@ -2,6 +2,7 @@
 #define KEYWORDS_H
 
 #include "history.h"
+#include "snapshot.h"
 #include <string>
 #include <map>
 #include <set>
@@ -10,57 +11,69 @@
 #include <string_view>
 
 namespace fs = std::filesystem;
-using Filenames = std::map<int16_t, fs::path>;
 
-void reloadMenu(Filenames& filePaths, Filenames& filePaths_copy, 
-                std::set<fs::path> directories, const fs::path programName);
+void reloadMenu(Filenames& filePaths, DirectorySnapshot& snapshot,
+                const std::set<fs::path>& directories);
 
 void keywordDefaultReplace(std::string& pattern, Filenames& filePaths, 
-                           HistoryData& history);
+                           DirectorySnapshot& snapshot, HistoryData& history);
 
 void keywordHelpMenu();
 
-void keywordAddAllDirs(std::set<fs::path>& directories,
-                       Filenames& filePaths, Filenames& filePaths_copy);
+void keywordAddAllDirs(std::set<fs::path>& directories, Filenames& filePaths);
 
-void keywordRemoveDir(std::string pattern, std::set<fs::path>& directories,
-                       Filenames& filePaths, Filenames& filePaths_copy);
+// Add every subdirectory of the working directories (adir++ [levels] [-skip])
+void keywordAddTree(const std::string& pattern, std::set<fs::path>& directories);
+
+void keywordRemoveDir(std::string pattern, std::set<fs::path>& directories);
 
 void keywordChangeDir(const std::string& pattern, std::set<fs::path>& directories, 
-                      Filenames& filePaths, Filenames& filePaths_copy, 
                       const bool add = false);
 
 void keywordRemoveFilename(const std::string& pattern, 
                            Filenames& filePaths,
-                           Filenames& filePaths_copy);
+                           const Filenames& filePaths_copy);
 
 void keywordRemoveAllFilenames(const std::string& pattern, 
                            Filenames& filePaths,
-                           Filenames& filePaths_copy);
+                           const Filenames& filePaths_copy);
 
-void keywordRemoveDots(Filenames& filePaths, HistoryData& history);
+void keywordRemoveDots(Filenames& filePaths, DirectorySnapshot& snapshot, 
+                       HistoryData& history);
 
-void keywordBetween(Filenames& filePaths, HistoryData& history, bool plus=false);
+void keywordBetween(Filenames& filePaths, DirectorySnapshot& snapshot, 
+                    HistoryData& history, bool plus=false);
 
 void keywordCapOrLower(Filenames& filePaths, std::string_view pattern,
-                       HistoryData& history);
+                       DirectorySnapshot& snapshot, HistoryData& history);
 
 void keywordPWD(const std::set<fs::path>& directories);
 
-void keywordSeries(Filenames& filePaths, HistoryData& history);
+// Rename keywords joined with |, applied in memory and renamed once
+void keywordChain(const std::string& pattern, Filenames& filePaths,
+                  DirectorySnapshot& snapshot, HistoryData& history);
+
+void keywordSeries(Filenames& filePaths, DirectorySnapshot& snapshot, 
+                   HistoryData& history);
 
 void keywordPrintToFile(Filenames& filePaths, bool& showNums, std::set<fs::path> directories);
 
-void keywordRenameSubs(Filenames& filePaths, HistoryData& history);
+void keywordRenameSubs(Filenames& filePaths, DirectorySnapshot& snapshot, HistoryData& history);
 
 void keywordRemoveDirectories(Filenames& filePaths, bool remove = true);
 
 void keywordWordCount(Filenames& filePaths);
 
-void keywordHistory(HistoryData& history, Filenames& filePaths);
+void keywordTrace(const std::string& pattern, HistoryData& history, const Filenames& filePaths);
+
+void keywordHistory(HistoryData& history, Filenames& filePaths, DirectorySnapshot& snapshot);
 
 void keywordToggleHistory(HistoryData& history);
 
 void keywordFind(std::string& pat, Filenames& filePaths, bool remove = false);
 
+// Time and counts of each phase of the last command and the session
+// (!stats), or as JSON (!stats json [file])
+void keywordStats(const std::string& pattern);
+
 #endif
\ No newline at end of file
@@ -1,32 +1,286 @@
 #include "keywords.h"
+#include "chain.h"
 #include "colors.h"
 #include "history.h"
+#include "pager.h"
 #include "rnFunctions.h"
-#include <windows.h>
+#include "snapshot.h"
+#include "stats.h"
+#include "stream.h"
+#include <fstream>
 #include <iostream>
 #include <filesystem>
+#include <algorithm>
 #include <map>
+#include <string>
+#include <system_error>
 #include <utility>
 #include <vector>
 #include <set>
 
 namespace fs = std::filesystem;
-using Filenames = std::map<int16_t, fs::path>;
+
+// Exit codes of batch mode
+namespace BatchExit
+{
+    inline constexpr int done{0};           // Everything planned was renamed (or previewed)
+    inline constexpr int noMatches{1};      // Nothing to rename
+    inline constexpr int usage{2};
+    inline constexpr int skipped{3};        // Some files were left out (name conflicts)
+    inline constexpr int failed{4};         // Some renames failed
+    inline constexpr int interrupted{5};    // Recover the last batch interactively first
+}
+
+
+
+void printBatchUsage()
+{
+    std::cout << 
+        "Usage: renamec [--dir DIR]... [--tree] [--stream] ACTION [--yes] [--no-history]\n"
+        "\nActions:"
+        "\n--find PAT --replace NEW            Same as entering PAT, then NEW."
+        "\n--between LEFT RIGHT --replace NEW  Same as between."
+        "\n--between+ LEFT RIGHT --replace NEW Same as between+."
+        "\n--series                            Same as !series."
+        "\n--chain \"A | B | ...\"               Same as entering the chain."
+        "\n\nOptions:"
+        "\n--dir DIR                           Working directory (repeatable, default: current)."
+        "\n--tree                              Add every subdirectory (files go before folders)."
+        "\n--depth N                           Only N levels of subdirectories with --tree."
+        "\n--skip PAT                          Leave out folders matching PAT with --tree."
+        "\n--stream                            Rename while reading, a chunk at a time (huge folders)."
+        "\n--yes                               Rename. Without it the renames are only printed."
+        "\n--no-history                        Don't save these renames to history."
+        "\n--stats FILE                        Save the time and counts of each phase as JSON."
+        "\n\nExit codes: 0 done, 1 no matches, 2 bad arguments, 3 files skipped,"
+        "\n4 renames failed, 5 an interrupted rename needs recovering.\n";
+}
+
+
+
+// Run one rename from command line arguments, without prompts or colours
+int runBatch(const std::vector<std::string>& args, const fs::path& programName)
+{
+    std::set<fs::path> directories{};
+    std::string action{};
+    std::string pattern{};
+    std::string lpat{};
+    std::string rpat{};
+    std::string replacement{};
+    bool hasReplacement{};
+    bool confirm{};
+    bool saveHistory{true};
+    bool tree{};
+    bool stream{};
+    std::size_t depth{};
+    std::string skip{};
+    std::string statsFile{};
+
+    for (std::size_t idx{}; idx < args.size(); ++idx)
+    {
+        const std::string& arg{args[idx]};
+        std::size_t remaining{args.size() - idx - 1};
+        bool isAction{arg == "--find" || arg == "--between" || arg == "--between+" ||
+                      arg == "--series" || arg == "--chain"};
+
+        if (arg == "--help" || arg == "-h")
+        {
+            printBatchUsage();
+            return BatchExit::done;
+        }
+        else if (isAction && !action.empty())
+        {
+            std::cerr << "Only one of --find, --between, --between+, --series and --chain can be given.\n";
+            return BatchExit::usage;
+        }
+        else if (arg == "--dir" && remaining >= 1)
+        {
+            std::error_code ec{};
+            fs::path dir{fs::canonical(args[++idx], ec)};
+            if (ec || !fs::is_directory(dir, ec))
+            {
+                std::cerr << "Not a directory: " << args[idx] << '\n';
+                return BatchExit::usage;
+            }
+            directories.insert(dir);
+        }
+        else if (arg == "--find" && remaining >= 1)
+        {
+            action = arg;
+            pattern = args[++idx];
+        }
+        else if ((arg == "--between" || arg == "--between+") && remaining >= 2)
+        {
+            action = arg;
+            lpat = args[++idx];
+            rpat = args[++idx];
+        }
+        else if (arg == "--chain" && remaining >= 1)
+        {
+            action = arg;
+            pattern = args[++idx];
+        }
+        else if (arg == "--series")
+            action = arg;
+        else if (arg == "--replace" && remaining >= 1)
+        {
+            replacement = args[++idx];
+            hasReplacement = true;
+        }
+        else if (arg == "--tree")
+            tree = true;
+        else if (arg == "--stream")
+            stream = true;
+        else if (arg == "--depth" && remaining >= 1)
+        {
+            try
+            {
+                depth = std::stoul(args[++idx]);
+            }
+            catch(const std::exception& e)
+            {
+                std::cerr << "Not a number of levels: " << args[idx] << '\n';
+                return BatchExit::usage;
+            }
+        }
+        else if (arg == "--skip" && remaining >= 1)
+            skip = args[++idx];
+        else if (arg == "--yes" || arg == "-y")
+            confirm = true;
+        else if (arg == "--no-history")
+            saveHistory = false;
+        else if (arg == "--stats" && remaining >= 1)
+            statsFile = args[++idx];
+        else
+        {
+            std::cerr << "Unknown or incomplete argument: " << arg << "\n\n";
+            printBatchUsage();
+            return BatchExit::usage;
+        }
+    }
+
+    bool needsReplacement{action != "--series" && action != "--chain"};
+    if (action.empty() || (needsReplacement && !hasReplacement) ||
+        ((action == "--find" || action == "--chain") && pattern.empty()))
+    {
+        std::cerr << "An action and its replacement are needed.\n\n";
+        printBatchUsage();
+        return BatchExit::usage;
+    }
+
+    // Streaming goes through a chain, renaming each chunk as it is read
+    RenameChain chain{action == "--chain" ? pattern : ""};
+    if (action == "--find")
+        chain.addReplace(pattern, replacement);
+    else if (action == "--between" || action == "--between+")
+        chain.addBetween(lpat, rpat, replacement, action == "--between+");
+    if (!chain.error.empty())
+    {
+        std::cerr << chain.error << '\n';
+        return BatchExit::usage;
+    }
+    if (stream && (action == "--series" || chain.numbered()))
+    {
+        std::cerr << "--stream can't be used with --series or #^ (they need every match at once).\n";
+        return BatchExit::usage;
+    }
+
+    if (directories.empty())
+        directories.insert(fs::canonical("."));
+    if (tree)
+        directories.merge(getSubdirectories(directories, depth, skip));
+
+    stats.begin(action);
+    setColorEnabled(false);
+    Pager::pageSize = 0;
+    batchMode.active = true;
+    batchMode.confirm = confirm;
+
+    // A rename left half done would be overwritten by the next one
+    HistoryData history{programName};
+    if (history.interrupted())
+    {
+        std::cerr << "A rename was interrupted. Run renamec without arguments to finish or undo it.\n";
+        return BatchExit::interrupted;
+    }
+    history.recover();
+    history.saveHistory = history.saveHistory && saveHistory;
+
+    if (stream)
+    {
+        std::vector<fs::path> deepestFirst{directories.begin(), directories.end()};
+        std::stable_sort(deepestFirst.begin(), deepestFirst.end(), [](const fs::path& a, const fs::path& b)
+        {
+            return std::distance(a.begin(), a.end()) > std::distance(b.begin(), b.end());
+        });
+        StreamRenamer streamer{chain, history, programName, confirm};
+        for (auto& dir : deepestFirst)
+            streamer.run(dir);
+        std::cout << '\n' << (confirm ? batchMode.renamed : batchMode.planned) << " filenames " 
+                  << (confirm ? "were renamed" : "will be renamed") << ".\n";
+    }
+    else
+    {
+        DirectorySnapshot snapshot{programName};
+        snapshot.reload(directories);
+        Filenames filePaths{snapshot.files};
+
+        if (action == "--find")
+        {
+            batchMode.answers = {replacement};
+            keywordDefaultReplace(pattern, filePaths, snapshot, history);
+        }
+        else if (action == "--series")
+            keywordSeries(filePaths, snapshot, history);
+        else if (action == "--chain")
+            keywordChain(pattern, filePaths, snapshot, history);
+        else
+        {
+            batchMode.answers = {lpat, rpat, replacement};
+            keywordBetween(filePaths, snapshot, history, action == "--between+");
+        }
+    }
+
+    if (!statsFile.empty() && !(std::ofstream{statsFile} << stats.json()))
+        std::cerr << "Cannot write " << statsFile << '\n';
+
+    if (batchMode.failed)
+        return BatchExit::failed;
+    if (batchMode.skipped)
+        return BatchExit::skipped;
+    if (!batchMode.planned)
+        return BatchExit::noMatches;
+    if (batchMode.errors)
+        return BatchExit::skipped;
+    return BatchExit::done;
+}
+
+
 
 int main(int argc, char* argv[])
 {
     const fs::path programName{argv[0]};
+    if (argc > 1)
+        return runBatch(std::vector<std::string>(argv + 1, argv + argc), programName);
+
     HistoryData history{programName};
+    history.recover();
     std::string pattern{};
-    std::set<fs::path> directories{fs::canonical(".\\")};
-    Filenames filePaths{getFilenames(directories, programName)};
-    Filenames filePaths_copy{};      // Used to restore filenames to menu
+    std::set<fs::path> directories{fs::canonical(".")};
+    DirectorySnapshot snapshot{programName};
+    snapshot.reload(directories);
+    Filenames filePaths{snapshot.files};
+    const Filenames& filePaths_copy{snapshot.files};  // Used to restore filenames to menu
     bool showNums{};                 // Toggle printing index #
+    Pager menuPage{};
 
     while (true)
     {
-        filePaths_copy = getFilenames(directories, programName);
-        printFilenames(filePaths, showNums);
+        snapshot.update();
+        directories = snapshot.directories;     // Renamed working directories
+        clearRenamePreview();
+        menuPage.resize(filePaths.size());
+        printFilenames(filePaths, menuPage, showNums, filePaths_copy.size() - filePaths.size());
 
         setColor(Color::pink);
         std::cout << "\nKeyword examples: !help, chdir, between, !series, !history, q\n";
@@ -36,34 +290,45 @@ int main(int argc, char* argv[])
 
         // Check for keywords:
         if (pattern == "")
-            { std::cout << '\n'; history.saveToFile(); break; }
+            { std::cout << '\n'; break; }
 
         else if (pattern == "!help" ) 
             { keywordHelpMenu(); getline(std::cin, pattern); }
 
+        // !stats shows the command before it
+        if (pattern.rfind("!stats", 0) != 0)
+            stats.begin(pattern);
+
         if (pattern == "q" || pattern == "exit") // New if statement for help menu
-            { std::cout << '\n'; history.saveToFile(); break; }
+            { std::cout << '\n'; break; }
 
         else if (pattern == "!index") 
             showNums = !showNums;
 
+        else if (menuPage.command(pattern))
+            continue;
+
         else if (pattern.rfind("chdir", 0) == 0){
-            keywordChangeDir(pattern, directories, filePaths, filePaths_copy);
-            reloadMenu(filePaths, filePaths_copy, directories, programName);}
+            keywordChangeDir(pattern, directories);
+            reloadMenu(filePaths, snapshot, directories);}
+
+        else if (pattern.rfind("adir++", 0) == 0){
+            keywordAddTree(pattern, directories);
+            reloadMenu(filePaths, snapshot, directories);}
 
         else if (pattern == "adir+"){
-            keywordAddAllDirs(directories, filePaths, filePaths_copy);
-            reloadMenu(filePaths, filePaths_copy, directories, programName);}
+            keywordAddAllDirs(directories, filePaths);
+            reloadMenu(filePaths, snapshot, directories);}
 
         else if (pattern.rfind("adir", 0) == 0){
-            keywordChangeDir(pattern, directories, filePaths, filePaths_copy, true);
-            reloadMenu(filePaths, filePaths_copy, directories, programName);}
+            keywordChangeDir(pattern, directories, true);
+            reloadMenu(filePaths, snapshot, directories);}
 
         else if (pattern == "!pwd")
             keywordPWD(directories);
 
         else if (pattern == "!reload")
-            reloadMenu(filePaths, filePaths_copy, directories, programName);
+            reloadMenu(filePaths, snapshot, directories);
 
         else if (pattern == "rmfolders")
             keywordRemoveDirectories(filePaths);
@@ -72,8 +337,8 @@ int main(int argc, char* argv[])
             keywordRemoveDirectories(filePaths, false);
 
         else if (pattern.rfind("rmdir", 0) == 0){
-            keywordRemoveDir(pattern, directories, filePaths, filePaths_copy);
-            reloadMenu(filePaths, filePaths_copy, directories, programName);}
+            keywordRemoveDir(pattern, directories);
+            reloadMenu(filePaths, snapshot, directories);}
 
         else if (pattern.rfind("rm-", 0) == 0)
             keywordRemoveAllFilenames(pattern, filePaths, filePaths_copy);
@@ -82,19 +347,19 @@ int main(int argc, char* argv[])
             keywordRemoveFilename(pattern, filePaths, filePaths_copy);
 
         else if (pattern == "!dots")
-            keywordRemoveDots(filePaths, history);
+            keywordRemoveDots(filePaths, snapshot, history);
 
         else if (pattern == "between")
-            keywordBetween(filePaths, history);
+            keywordBetween(filePaths, snapshot, history);
 
         else if (pattern == "between+")
-            keywordBetween(filePaths, history, true);
+            keywordBetween(filePaths, snapshot, history, true);
 
         else if (pattern == "!lower" || pattern == "!cap")
-            keywordCapOrLower(filePaths, pattern, history);
+            keywordCapOrLower(filePaths, pattern, snapshot, history);
 
         else if (pattern == "!series")
-            keywordSeries(filePaths, history);
+            keywordSeries(filePaths, snapshot, history);
 
         else if (pattern == "!print")
             keywordPrintToFile(filePaths, showNums, directories);
@@ -103,7 +368,7 @@ int main(int argc, char* argv[])
             keywordWordCount(filePaths);
 
         else if (pattern == "!rnsubs")
-            keywordRenameSubs(filePaths, history);
+            keywordRenameSubs(filePaths, snapshot, history);
 
         else if (pattern.rfind("!find", 0) == 0)
             keywordFind(pattern, filePaths);
@@ -112,17 +377,26 @@ int main(int argc, char* argv[])
             keywordFind(pattern, filePaths, true);
 
         else if (pattern == "!undo")
-            undoRename(history, 0, filePaths);
+            undoRename(history, {0}, filePaths, snapshot);
 
         else if (pattern == "!history")
-            keywordHistory(history, filePaths);
+            keywordHistory(history, filePaths, snapshot);
+
+        else if (pattern.rfind("!trace", 0) == 0)
+            keywordTrace(pattern, history, filePaths);
+
+        else if (pattern.rfind("!stats", 0) == 0)
+            keywordStats(pattern);
 
         else if (pattern == "!togglehistory")
             keywordToggleHistory(history);
         
+        else if (RenameChain::isChain(pattern))
+            keywordChain(pattern, filePaths, snapshot, history);
+
         // Get second pattern:
         else if (pattern != "")  // Pattern check for help menu (skip to filename menu)
-            keywordDefaultReplace(pattern, filePaths, history);
+            keywordDefaultReplace(pattern, filePaths, snapshot, history);
     }
     return 0;
 }
\ No newline at end of file
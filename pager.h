@@ -0,0 +1,87 @@
+#ifndef PAGER_H
+#define PAGER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <string>
+
+// A window over a long list (the menu or a preview). Only the rows on the
+// current page are formatted. !next, !prev, !page # and !pagesize # move it.
+class Pager
+{
+public:
+    static inline std::size_t pageSize{40};   // 0: every row on one page
+    std::size_t total{};
+    std::size_t page{};
+
+    explicit Pager(std::size_t rows = 0)
+        : total{rows} {}
+
+    std::size_t pages() const
+    {
+        if (!pageSize || !total)
+            return 1;
+        return (total + pageSize - 1) / pageSize;
+    }
+
+    // Rows first() ... last()-1 are on the page
+    std::size_t first() const { return pageSize ? std::min(page, pages() - 1) * pageSize : 0; }
+    std::size_t last() const { return pageSize ? std::min(first() + pageSize, total) : total; }
+
+    bool visible(std::size_t row) const { return row >= first() && row < last(); }
+
+    bool paged() const { return pages() > 1; }
+
+    // Change the number of rows, keeping the page in range
+    void resize(std::size_t rows)
+    {
+        total = rows;
+        page = std::min(page, pages() - 1);
+    }
+
+    // Move the window for a paging keyword. False if input isn't one.
+    bool command(const std::string& input)
+    {
+        if (input == "!next")
+            page = std::min(page + 1, pages() - 1);
+        else if (input == "!prev")
+            page = page ? page - 1 : 0;
+        else if (input.rfind("!page", 0) == 0)
+        {
+            bool size{input.rfind("!pagesize", 0) == 0};
+            std::size_t number{};
+            try
+            {
+                number = std::stoul(input.substr(size ? 9 : 5));
+            }
+            catch(const std::exception& e)
+            {
+                return false;
+            }
+            if (size)
+            {
+                std::size_t row{first()};
+                pageSize = number;
+                page = pageSize ? row / pageSize : 0;
+            }
+            else
+                page = std::min(number ? number - 1 : 0, pages() - 1);
+        }
+        else
+            return false;
+        return true;
+    }
+
+    // Rows shown, e.g. "rows 41-80 of 1000 (page 2/25)"
+    std::string range() const
+    {
+        if (!total)
+            return "0 rows";
+        return "rows " + std::to_string(first() + 1) + "-" + std::to_string(last()) +
+               " of " + std::to_string(total) + " (page " + std::to_string(std::min(page, pages() - 1) + 1) +
+               "/" + std::to_string(pages()) + ")";
+    }
+};
+
+#endif
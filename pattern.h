@@ -0,0 +1,109 @@
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#include <algorithm>  // For transform
+#include <cstddef>
+#include <regex>
+#include <string>
+#include <vector>
+
+// make a regex string with ? converted to [0-9]
+std::string makeRegex(const std::string& pattern);
+
+
+
+// A search pattern (? any digit, * zero or one of any character) compiled
+// once per command. Patterns without wildcards skip regex entirely.
+class Pattern
+{
+public:
+    std::string pattern{};
+    bool literal{true};
+    bool hasDigits{};
+
+private:
+    std::regex regexPattern{};
+
+public:
+    Pattern() = default;
+
+    explicit Pattern(std::string pat, bool lower = true)
+        {
+            if (lower)
+                transform(pat.begin(), pat.end(), pat.begin(), ::tolower);
+            pattern = pat;
+            hasDigits = pattern.find('?') != std::string::npos;
+            literal = !hasDigits && pattern.find('*') == std::string::npos;
+            if (!literal)
+                regexPattern = std::regex{makeRegex(pattern)};
+        }
+
+    // Position and length of the first match, false if there is none
+    bool search(const std::string& filename, std::size_t& pos, std::size_t& length) const
+    {
+        if (literal)
+        {
+            pos = filename.find(pattern);
+            length = pattern.length();
+            return pos != std::string::npos && length;
+        }
+        std::smatch sm{};
+        if (!std::regex_search(filename, sm, regexPattern) || !sm.length(0))
+            return false;
+        pos = sm.position(0);
+        length = sm.length(0);
+        return true;
+    }
+
+    // bool check for pattern, converting ? into any number
+    bool check(const std::string& filename) const
+    {
+        std::size_t pos{};
+        std::size_t length{};
+        return search(filename, pos, length);
+    }
+
+    // Matched text of the first (or last) occurance, or the pattern if none
+    std::string matchText(const std::string& filename, bool right = false) const
+    {
+        if (literal)
+            return pattern;
+
+        if (!right)
+        {
+            std::smatch sm{};
+            if (!std::regex_search(filename, sm, regexPattern) || !sm.length(0))
+                return pattern;
+            return sm.str(0);
+        }
+
+        // Get last occurance of pattern (simulates rfind)
+        std::string match{};
+        auto end{std::sregex_iterator{}};
+        for (auto it = std::sregex_iterator{filename.begin(), filename.end(), regexPattern};
+             it != end; ++it)
+        {
+            if (it->length(0))
+                match = it->str(0);
+        }
+        if (match == "")
+            return pattern;
+        return match;
+    }
+
+    // For ? inside replacement pattern, return all the digits matched
+    std::vector<std::string> digits(const std::string& filename) const
+    {
+        std::vector<std::string> digits{};
+        if (!hasDigits)
+            return digits;
+
+        std::smatch sm{};
+        std::regex_search(filename, sm, regexPattern);
+        for (std::size_t x{1}; x < sm.size(); ++x)
+            digits.push_back(sm[x]);
+        return digits;
+    }
+};
+
+#endif
@@ -1,35 +1,99 @@
 #include "colors.h"
 #include "history.h"
+#include "conflicts.h"
+#include "pager.h"
+#include "pattern.h"
+#include "rnFunctions.h"
+#include "stats.h"
 #include <algorithm>  // For transform
+#include <atomic>
 #include <cstddef>
+#include <exception>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <regex>
 #include <set>
+#include <system_error>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace fs = std::filesystem;
-using Filenames = std::map<int16_t, fs::path>;
 
+BatchMode batchMode{};
+
+namespace
+{
+    // A row of the rename preview: a change, or a skipped file's message.
+    // Rows are kept while paging so other pages can be formatted later.
+    struct PreviewRow
+    {
+        fs::path oldPath{};
+        fs::path newPath{};
+        std::string skipped{};
+    };
+
+    std::vector<PreviewRow> previewRows{};
+    std::size_t previewSkipped{};
+
+    void formatPreviewRow(const PreviewRow& row)
+    {
+        if (!row.skipped.empty())
+            screen.color(Color::red) << row.skipped << '\n';
+        else
+        {
+            screen.color(Color::pink) << row.oldPath.filename().string();
+            screen.color(Color::green) << "\n   ---->" << row.newPath.filename().string() << '\n';
+        }
+        screen.reset();
+    }
+}
+
+
+
+std::string readInput(std::string_view prompt)
+{
+    std::string input{};
+    if (!batchMode.active)
+    {
+        std::cout << prompt;
+        std::getline(std::cin, input);
+    }
+    else if (batchMode.nextAnswer < batchMode.answers.size())
+        input = batchMode.answers[batchMode.nextAnswer++];
+    return input;
+}
 
 
 void printPause()
 {
+    if (batchMode.active)
+        return;
     std::cout << "\nPress ENTER to continue...\n> ";
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 }
 
 
-void redErrorMessage(std::string_view s, bool pause = true)
+void redErrorMessage(std::string_view s, bool pause)
 {
-    setColor(Color::red);
+    if (batchMode.active)
+    {
+        screen.flush();
+        ++batchMode.errors;
+        std::cerr << s << '\n';
+        return;
+    }
+    screen.color(Color::red);
     if (pause)
-        std::cout << '\n';
-    std::cout << s << '\n';
-    resetColor();
+        screen << '\n';
+    screen << s << '\n';
+    screen.reset();
+    screen.flush();
     if (pause)
         printPause();
 }
@@ -60,40 +124,141 @@ void capitalize(std::string& s)
 
 
 
-bool renameErrorCheck(fs::path path, fs::path new_path)
+std::map<fs::path, fs::path> renameAndMenuUpdate(Filenames& newPaths, Filenames& oldPaths,
+                                                 HistoryData& history, DirectorySnapshot& snapshot,
+                                                 bool record)
 {
-    try
+    std::vector<MenuIndex> order{};
+    std::vector<RenameExecutor::Rename> renames{};
+    for (auto pair : newPaths)
     {
-        fs::rename(path, new_path);
-        return true;
+        order.push_back(pair.first);
+        renames.emplace_back(oldPaths[pair.first].path, pair.second.path);
     }
-    catch(const std::exception& e)
+
+    std::vector<std::error_code> results{history.journal.run(renames)};
+
+    // Report errors in the original order. Only renames that worked go to history
+    for (std::size_t pos{}; pos < order.size(); ++pos)
     {
-        redErrorMessage(e.what(), false);
-        return false;
+        if (results[pos])
+        {
+            fs::filesystem_error error{"cannot rename", renames[pos].first,
+                                       renames[pos].second, results[pos]};
+            redErrorMessage(error.what(), false);
+            newPaths.erase(order[pos]);
+            ++batchMode.failed;
+        }
     }
+    batchMode.renamed += newPaths.size();
+
+    // Renamed directories, old path -> final path (parents come first in the map)
+    std::map<fs::path, fs::path> movedDirs{};
+    for (auto pair : newPaths)
+    {
+        if (pair.second.isDirectory)
+            movedDirs[oldPaths[pair.first].path] = pair.second.path;
+    }
+    for (auto& [oldDir, newDir] : movedDirs)
+        newDir = movedPath(newDir, movedDirs);
+
+    // Files inside a renamed directory are recorded under its new name, so
+    // undoing the entry renames them back before the directory
+    if (record && history.saveHistory)
+    {
+        HistoryLog::OldNewFiles historyUpdate{};
+        for (auto pair : newPaths)
+        {
+            historyUpdate[movedPath(oldPaths[pair.first].path, movedDirs)] =
+                movedPath(pair.second.path, movedDirs);
+        }
+        history.add(historyUpdate);
+    }
+
+    for (auto pair : newPaths)
+        oldPaths[pair.first] = pair.second;
+    followMovedDirs(oldPaths, movedDirs);
+    snapshot.moveDirectories(movedDirs);
+    return movedDirs;
+}
+
+
+
+fs::path movedPath(const fs::path& path, const std::map<fs::path, fs::path>& movedDirs)
+{
+    if (movedDirs.empty())
+        return path;
+    for (fs::path dir{path.parent_path()}; !dir.empty(); dir = dir.parent_path())
+    {
+        auto moved{movedDirs.find(dir)};
+        if (moved != movedDirs.end())
+            return moved->second / path.lexically_relative(dir);
+        if (dir == dir.parent_path())
+            break;
+    }
+    return path;
 }
 
 
 
-void renameAndMenuUpdate(Filenames& newPaths, Filenames& oldPaths)
+void followMovedDirs(Filenames& files, const std::map<fs::path, fs::path>& movedDirs)
 {
-    for (auto& pair: newPaths)
+    if (movedDirs.empty())
+        return;
+    for (auto pair : files)
     {
-        fs::path newPath = pair.second;
+        fs::path path{movedPath(pair.second.path, movedDirs)};
+        if (path != pair.second.path)
+            pair.second = pair.second.renamed(path);
+    }
+}
+
 
-        // Rename files. If successful update menu
-        if ( renameErrorCheck(oldPaths[pair.first], newPath) )
+
+std::set<fs::path> getSubdirectories(const std::set<fs::path>& dirs, std::size_t depth,
+                                     const std::string& skip)
+{
+    // One level at a time, the directories of each level listed concurrently
+    const Pattern skipPattern{skip};
+    std::set<fs::path> found{};
+    std::vector<fs::path> level{dirs.begin(), dirs.end()};
+    for (std::size_t num{}; !level.empty() && (!depth || num < depth); ++num)
+    {
+        std::vector<std::vector<fs::path>> children(level.size());
+        parallelFor(level.size(), [&](std::size_t idx)
         {
-            oldPaths[pair.first] = newPath;
+            std::error_code ec{};
+            for (fs::directory_iterator it{level[idx], ec}, end{}; !ec && it != end; it.increment(ec))
+            {
+                // Links are left out so a loop can't be followed forever
+                std::error_code typeEc{};
+                if (!it->is_directory(typeEc) || it->is_symlink(typeEc))
+                    continue;
+                if (!skip.empty() && skipPattern.check(lowercase(it->path().filename().string())))
+                    continue;
+                children[idx].push_back(it->path());
+            }
+        }, 16);
+
+        level.clear();
+        for (auto& list : children)
+        {
+            for (auto& child : list)
+            {
+                if (found.insert(child).second)
+                    level.push_back(child);
+            }
         }
     }
+    for (auto& dir : dirs)
+        found.erase(dir);
+    return found;
 }
 
 
 
 std::string strReplaceAll(std::string origin, const std::string& pat, 
-                          const std::string& newPat, const std::size_t start = 0)
+                          const std::string& newPat, const std::size_t start)
 {
     // Search is not case sensitive, but replacement pattern is
     std::string newString_lower{ lowercase(origin) };
@@ -114,7 +279,7 @@ std::string strReplaceAll(std::string origin, const std::string& pat,
 }
 
 
-std::string convertSequenceNumber(std::string& pattern, std::int16_t indexNum, size_t numOfFiles)
+std::string convertSequenceNumber(std::string& pattern, std::size_t indexNum, size_t numOfFiles)
 {
     if (pattern.find("#^") == std::string::npos)
         return pattern;
@@ -178,16 +343,7 @@ std::string makeRegex(const std::string& pattern)
 
 std::vector<std::string> extractDigits(const std::string& filename, const std::string& pattern)
 {
-    std::vector<std::string> digits{};
-    std::regex regexPat{makeRegex(pattern)};
-    std::smatch sm{};
-    std::regex_search(filename, sm, regexPat);
-
-    for (size_t x{1}; x < sm.size(); ++x )
-    {
-        digits.push_back(sm[x]);
-    }
-    return digits;
+    return Pattern{pattern, false}.digits(filename);
 }
 
 
@@ -214,11 +370,47 @@ std::string replaceDigits(const std::vector<std::string>& digits, std::string pa
 
 void printFileChange(const fs::path& oldPath, const fs::path& newPath)
 {
-    setColor(Color::pink);
-    std::cout << oldPath.filename().string();
-    setColor(Color::green);
-    std::cout << "\n   ---->" << newPath.filename().string() << '\n';
-    resetColor();
+    // Without paging (batch mode) nothing is kept
+    if (!Pager::pageSize)
+    {
+        formatPreviewRow({oldPath, newPath, {}});
+        return;
+    }
+    previewRows.push_back({oldPath, newPath, {}});
+    if (previewRows.size() <= Pager::pageSize)
+        formatPreviewRow(previewRows.back());
+}
+
+
+void printSkippedFile(std::string_view message)
+{
+    ++previewSkipped;
+    ++batchMode.skipped;
+    if (!Pager::pageSize)
+    {
+        redErrorMessage(message, false);
+        return;
+    }
+    previewRows.push_back({{}, {}, std::string{message}});
+    if (previewRows.size() <= Pager::pageSize)
+        formatPreviewRow(previewRows.back());
+}
+
+
+void clearRenamePreview()
+{
+    previewRows.clear();
+    previewSkipped = 0;
+}
+
+
+void printPageSummary(const Pager& pager, std::string_view counts)
+{
+    screen.color(Color::blue) << counts;
+    if (pager.paged())
+        screen << " Showing " << pager.range() << ".\n!next, !prev, !page #, !pagesize # to move.";
+    screen << '\n';
+    screen.reset();
 }
 
 
@@ -226,53 +418,26 @@ void printFileChange(const fs::path& oldPath, const fs::path& newPath)
 // bool check for pattern, converting ? into any number
 bool checkPatternWithRegex(const std::string& filename, const std::string& pattern)
 {
-    std::regex patternRegEx{ makeRegex(pattern) };
-    std::smatch sm;
-    std::regex_search(filename, sm, patternRegEx);
-    if (sm[0] == "")
-        return false;
-    return true;
+    return Pattern{pattern, false}.check(filename);
 }
 
 
 
 // Convert pattern, converting ? into number
 std::string convertPatternWithRegex(std::string filename, std::string pattern,
-                                    bool lower = true, bool right = false)
+                                    bool lower, bool right)
 {
     if (lower)
-    {
         toLowercase(filename);
-        toLowercase(pattern);
-    }
-    std::regex patternRegEx{ makeRegex(pattern) };
-
-    std::smatch sm;
+    return Pattern{pattern, lower}.matchText(filename, right);
+}
 
-    // Get first occurance of pattern
-    if (!right)
-    {
-        std::regex_search(filename, sm, patternRegEx);
-        if (sm[0] == "")
-            return pattern;
-        return sm[0];
-    }
-    
-    // Get last occurance of pattern (simulates rfind)
-    std::string match{};
-    while (std::regex_search(filename, sm, patternRegEx))
-    {
-        for (auto m : sm)
-        {
-            // match = m.str();
-            match = sm[0];
-        }
-        filename = sm.suffix().str();
-    }
-    if (match == "")
-        return pattern;
-    return match;
 
+// Same as above, reusing an already compiled pattern
+std::string convertPatternWithRegex(const std::string& filename, const Pattern& pattern,
+                                    bool right)
+{
+    return pattern.matchText(lowercase(filename), right);
 }
 
 
@@ -292,16 +457,37 @@ bool checkIfQuit(std::size_t index)
 {
     if (!index)
     {
+        clearRenamePreview();
         redErrorMessage("No filenames to change.");
         return true;
     }
-    setColor(Color::blue);
-    std::cout << "\n" << index << " filenames will be renamed.\n";
-    resetColor();
-    std::cout << "Press ENTER to rename files (or q to quit):\n> ";
+
+    // The first page was formatted while the preview was made
+    Pager pager{previewRows.size()};
     std::string query{};
-    std::getline(std::cin, query);
-    std::cout << '\n';
+    while (true)
+    {
+        std::string counts{'\n' + std::to_string(index) + " filenames will be renamed"};
+        if (previewSkipped)
+            counts += ", " + std::to_string(previewSkipped) + " skipped";
+        printPageSummary(pager, counts + '.');
+        screen.flush();
+        if (batchMode.active)
+        {
+            clearRenamePreview();
+            batchMode.planned = index;
+            return !batchMode.confirm;
+        }
+        std::cout << "Press ENTER to rename files (or q to quit):\n> ";
+        std::getline(std::cin, query);
+        std::cout << '\n';
+        if (!pager.command(query))
+            break;
+        PhaseTimer timer{Phase::preview, pager.last() - pager.first()};
+        for (std::size_t row{pager.first()}; row < pager.last(); ++row)
+            formatPreviewRow(previewRows[row]);
+    }
+    clearRenamePreview();
 
     if (query != "")
         return true;
@@ -310,14 +496,14 @@ bool checkIfQuit(std::size_t index)
 
 
 
-void removeDotEnds(fs::path& file, bool& dotAtStart)
+std::string removeDotEnds(const FileRecord& file, bool& dotAtStart)
 {
     std::string filename{};
 
-    if ( fs::is_directory(file) )
-        filename = file.filename().string();
+    if ( file.isDirectory )
+        filename = file.filename;
     else
-        filename = file.stem().string();
+        filename = file.stem();
 
     // Remove dot prefix
     if ( filename.starts_with('.') )
@@ -326,21 +512,56 @@ void removeDotEnds(fs::path& file, bool& dotAtStart)
         dotAtStart = true;
     }
 
-    file.replace_filename(filename);
+    return filename;
 }
 
 
 
-void restoreDotEnds(fs::path& newFile, const fs::path& file, 
+void restoreDotEnds(std::string& newFilename, const FileRecord& file, 
                     bool dotAtStart)
 {
     // Add file extension
-    if ( !fs::is_directory(file) )
-        newFile.replace_filename(newFile.filename() += file.extension());
+    if ( !file.isDirectory )
+        newFilename += file.extension();
 
     // Add dot prefix
     if (dotAtStart)
-        newFile.replace_filename("." + newFile.filename().string());
+        newFilename = "." + newFilename;
+}
+
+
+
+std::string replaceDots(const FileRecord& file)
+{
+    bool dotAtStart{};
+
+    // Remove suffix, and extension from filename if not folder
+    std::string newFilename{removeDotEnds(file, dotAtStart)};
+
+    // Check for matches
+    if ( newFilename.find(".") == std::string::npos )
+        return "";
+
+    // Remove dots from filename
+    newFilename = strReplaceAll(newFilename, ".", " ");
+
+    // Restore extension or suffix to filename
+    restoreDotEnds(newFilename, file, dotAtStart);
+    return newFilename;
+}
+
+
+
+bool patternMatches(const FileRecord& file, const std::string& pattern,
+                    const Pattern& compiledPattern, std::int16_t index)
+{
+    if (pattern == "#begin" || pattern == "#end")
+        return true;
+    if (pattern == "#ext" && !file.extension().empty() && !file.isDirectory)
+        return true;
+    if (pattern.rfind("#index", 0) == 0 && index <= file.filename.length())
+        return true;
+    return compiledPattern.check(file.lowerName);
 }
 
 
@@ -364,18 +585,19 @@ std::int16_t getIndex(const std::string& pattern)
 }
 
 
-fs::path renameFile(fs::path filePath, const std::string& pat, 
+fs::path renameFile(const FileRecord& file, const std::string& pat, 
                     std::string newPat)
 {
-    std::string filename{filePath.filename().string()};
-    std::string filenameStem{filePath.stem().string()};
+    fs::path filePath{file.path};
+    const std::string& filename{file.filename};
+    std::string filenameStem{file.stem()};
     std::int16_t set_index{getIndex(pat)};
 
     // Replace NewPat keywords
     if (newPat == "#begin" || newPat == "#end")
         newPat = "";
     else if (newPat == "#ext")
-        newPat = filePath.extension().string();
+        newPat = file.extension();
 
     // Rename a string of filename
     if (pat == "#begin")
@@ -383,7 +605,7 @@ fs::path renameFile(fs::path filePath, const std::string& pat,
     else if (pat == "#ext")
         filePath.replace_filename(filenameStem + newPat);
     else if (pat == "#end")
-        filePath.replace_filename(filenameStem + newPat + filePath.extension().string());
+        filePath.replace_filename(filenameStem + newPat + file.extension());
     else if (pat.rfind("#index", 0) == 0)
         filePath.replace_filename(filename.substr(0, set_index) + newPat + filename.substr(set_index));
     else
@@ -394,215 +616,309 @@ fs::path renameFile(fs::path filePath, const std::string& pat,
 
 
 
-Filenames getFilenames(const std::set<fs::path>& dirs, fs::path programName)
+void parallelFor(std::size_t count, const std::function<void(std::size_t)>& task,
+                 std::size_t maxWorkers)
 {
-    Filenames filePaths{};
-    int32_t idx{};
-    for (auto& dir: dirs)
+    std::size_t workers{maxWorkers ? maxWorkers : std::thread::hardware_concurrency()};
+    workers = std::min(std::max<std::size_t>(workers, 1), count);
+    if (workers <= 1)
     {
-        for ( fs::path path: fs::directory_iterator(dir) )
-            {
-                if (path == programName)
-                    continue;
+        for (std::size_t idx{}; idx < count; ++idx)
+            task(idx);
+        return;
+    }
 
-                filePaths[idx] = path;
-                ++idx;
+    std::atomic<std::size_t> next{};
+    std::exception_ptr error{};
+    std::mutex errorMutex{};
+    auto worker = [&]()
+    {
+        for (std::size_t idx{next++}; idx < count; idx = next++)
+        {
+            try
+            {
+                task(idx);
+            }
+            catch(...)
+            {
+                std::lock_guard<std::mutex> lock{errorMutex};
+                if (!error)
+                    error = std::current_exception();
             }
+        }
+    };
+
+    std::vector<std::thread> threads{};
+    for (std::size_t idx{1}; idx < workers; ++idx)
+        threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads)
+        thread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+
+
+Filenames getFilenames(const std::set<fs::path>& dirs, fs::path programName)
+{
+    // List directories concurrently (network mounts wait on each listing),
+    // then merge them in set order so index numbers never change
+    const std::vector<fs::path> dirList{dirs.begin(), dirs.end()};
+    PhaseTimer timer{Phase::scan};
+    timer.calls = dirList.size();
+    std::vector<std::vector<FileRecord>> listings(dirList.size());
+    parallelFor(dirList.size(), [&](std::size_t idx)
+    {
+        for ( const fs::directory_entry& entry: fs::directory_iterator(dirList[idx]) )
+        {
+            if (entry.path() == programName)
+                continue;
+            listings[idx].emplace_back(entry);
+        }
+    }, 16);
+
+    Filenames filePaths{};
+    std::size_t total{};
+    for (auto& listing: listings)
+        total += listing.size();
+    filePaths.reserve(total);
+    for (auto& listing: listings)
+    {
+        for (auto& record: listing)
+            filePaths.push_back(std::move(record));
     }
+    timer.items = total;
     return filePaths;
 }
 
 
 
-void printFilenames(const Filenames& paths, 
-                    const bool showNums=false)
+void printFilenames(const Filenames& paths, const Pager& pager,
+                    const bool showNums, std::size_t removed)
 {
-    setColor(Color::cyan);
-    std::cout << '\n';
+    PhaseTimer timer{Phase::preview, pager.last() - pager.first()};
+    screen.color(Color::cyan) << '\n';
 
+    std::size_t row{};
     for (const auto& pair: paths)
     {
+        if (row >= pager.last())
+            break;
+        if (!pager.visible(row++))
+            continue;
+
         // Print index number
         if (showNums)
-            std::cout << pair.first << ". ";
+            screen << pair.first << ". ";
 
-        std::cout << pair.second.filename().string() << '\n';
+        screen << pair.second.filename << '\n';
     }
-    resetColor();
-}
-
+    screen.reset();
 
-
-bool checkBetweenMatches(const fs::path& path, 
-                         std::string lpat, std::string rpat)
-{
-    std::string filename {path.filename().string()};
-
-    // Convert any ? into numerical digit
-    lpat = convertPatternWithRegex(filename, lpat);
-    rpat = convertPatternWithRegex(filename, rpat, true, true);
-    // Get index of patterns
-    std::size_t leftIndex{lowercase(filename).find(lowercase(lpat))};
-    std::size_t rightIndex{lowercase(filename).rfind(lowercase(rpat))};
-
-    // Check if matched
-    bool lmatch{leftIndex != std::string::npos};
-    bool rmatch{rightIndex != std::string::npos};
-
-    if (lpat == "#begin"){
-        leftIndex = 0;
-        lmatch = true;}
-    if (lpat == "#end" || lpat == "#ext"){
-        leftIndex = path.stem().string().length();
-        lmatch = true;}
-    if (rpat == "#begin"){
-        rightIndex = 0;
-        rmatch = true;}
-    if (rpat == "#end" || rpat == "#ext"){
-        rightIndex = path.stem().string().length();
-        rmatch = true;}
-
-    std::int16_t set_indexL{getIndex(lpat)};
-    std::int16_t set_indexR{getIndex(rpat)};
-
-    bool lKeywordIndex{lpat.rfind("#index", 0) == 0};
-    bool rKeywordIndex{rpat.rfind("#index", 0) == 0};
-
-    // Check if #index is inside of the other pattern
-    std::size_t lLen{lpat.length()};
-    std::size_t rLen{rpat.length()};
-    if (!lKeywordIndex && rKeywordIndex && (lpat != "#end") && (lpat != "#ext") && (lpat != "#begin") &&
-         !((set_indexR < leftIndex) || (set_indexR > leftIndex + lLen)))
-        return false; 
-
-    if (lKeywordIndex && !rKeywordIndex && (rpat != "#end") && (rpat != "#ext") && (rpat != "#begin") &&
-         !((set_indexL < rightIndex) || (set_indexL > rightIndex + lLen)))
-        return false; 
-
-    // switch indexes if both set with #index but in wrong order:
-    if ((set_indexL > set_indexR) && (lKeywordIndex && rKeywordIndex))
-        std::swap(set_indexL, set_indexR);
-    if (lKeywordIndex && (set_indexL <= filename.length()))
-        lmatch = true;
-    if (rKeywordIndex && set_indexR <= filename.length())
-        rmatch = true;
-
-    // Make sure both patterns aren't #index with same number
-    if ( lKeywordIndex && rKeywordIndex && (lpat == rpat) )
-        lmatch = false;
-
-    // indexes not the same AND no keyword #index
-    if ((lmatch && rmatch) && ((leftIndex != rightIndex) && (!lKeywordIndex && !rKeywordIndex)))
-        return true; 
-    else if ((lmatch && rmatch) && (lKeywordIndex || rKeywordIndex))
-        return true;
-    return false;
+    if (pager.paged() || removed)
+    {
+        std::string counts{'\n' + std::to_string(paths.size()) + " filenames"};
+        if (removed)
+            counts += " (" + std::to_string(removed) + " removed)";
+        printPageSummary(pager, counts + '.');
+    }
+    timer.stop();
+    screen.flush();
 }
 
 
-fs::path getBetweenFilename(const fs::path& path, 
-                            std::string lpat, std::string rpat,
-                            std::string replacement, bool plus)
-{
-    std::string filename {path.filename().string()};
-
 
+BetweenMatch matchBetween(const FileRecord& file, const Pattern& lpattern,
+                          const Pattern& rpattern, bool plus)
+{
+    BetweenMatch match{};
+    match.path = file.path;
+    match.filename = file.filename;
+    match.plus = plus;
+    const std::string& filename{file.filename};
+    const std::string& filename_lower{file.lowerName};
+    const std::size_t stemLength{file.stemLength};
+    const std::size_t extLength{filename.length() - stemLength};
 
     // extract digits into vector to use with ? in replacement pattern
-    std::vector<std::string> digits{};
-    std::vector<std::string> rdigits{};
-    bool lpatHasQ{lpat.find("?") != std::string::npos};
-    bool rpatHasQ{rpat.find("?") != std::string::npos};
-    bool replaceHasQ{replacement.find("?") != std::string::npos};
-    if ( (lpatHasQ || rpatHasQ) && replaceHasQ )
+    if (lpattern.hasDigits || rpattern.hasDigits)
     {
-        digits = extractDigits(lowercase(filename), lowercase(lpat));
-        rdigits = extractDigits(lowercase(filename), lowercase(rpat));
-        digits.insert(digits.end(), rdigits.begin(), rdigits.end());
+        match.digits = lpattern.digits(filename_lower);
+        std::vector<std::string> rdigits{rpattern.digits(filename_lower)};
+        match.digits.insert(match.digits.end(), rdigits.begin(), rdigits.end());
     }
 
     // Convert any ? into numerical digit
-    lpat = convertPatternWithRegex(filename, lpat);
-    rpat = convertPatternWithRegex(filename, rpat, true, true);
+    const std::string lpat{lpattern.matchText(filename_lower)};
+    const std::string rpat{rpattern.matchText(filename_lower, true)};
 
     // Get index of patterns
-    std::size_t leftIndex{lowercase(filename).find(lowercase(lpat))};
-    std::size_t rightIndex{lowercase(filename).rfind(lowercase(rpat))};
-
-    // Check if matched
-    bool lKeywordIndex{ lpat.rfind("#index", 0) == 0 };
-    bool rKeywordIndex{ rpat.rfind("#index", 0) == 0 };
-    bool lmatch{leftIndex != std::string::npos};
-    bool rmatch{rightIndex != std::string::npos};
-    std::int16_t set_indexL{getIndex(lpat)};
-    std::int16_t set_indexR{getIndex(rpat)};
-    if (lKeywordIndex && set_indexL <= filename.length())
-        lmatch = true;
-    if (rKeywordIndex && set_indexR <= filename.length())
-        rmatch = true;
-    if (lpat == "#begin" || lpat == "#end" || lpat == "#ext")
-        lmatch = true;
-    if (rpat == "#begin" || rpat == "#end" || rpat == "#ext")
-        rmatch = true;
-    if (!(lmatch && rmatch))
-        return "";
+    const std::size_t foundLeft{filename_lower.find(lpat)};
+    const std::size_t foundRight{filename_lower.rfind(rpat)};
+
+    // Resolve pattern keywords once
+    const bool lBegin{lpat == "#begin"};
+    const bool rBegin{rpat == "#begin"};
+    const bool lEnd{lpat == "#end" || lpat == "#ext"};
+    const bool rEnd{rpat == "#end" || rpat == "#ext"};
+    const bool lKeyword{lBegin || lEnd};
+    const bool rKeyword{rBegin || rEnd};
+    const bool lKeywordIndex{lpat.rfind("#index", 0) == 0};
+    const bool rKeywordIndex{rpat.rfind("#index", 0) == 0};
+    const std::int16_t indexL{getIndex(lpat)};
+    const std::int16_t indexR{getIndex(rpat)};
+
+    // Check if matched (used for preview and match count)
+    {
+        std::size_t leftIndex{lBegin ? 0 : (lEnd ? stemLength : foundLeft)};
+        std::size_t rightIndex{rBegin ? 0 : (rEnd ? stemLength : foundRight)};
+        bool lmatch{lKeyword || leftIndex != std::string::npos};
+        bool rmatch{rKeyword || rightIndex != std::string::npos};
+        std::int16_t set_indexL{indexL};
+        std::int16_t set_indexR{indexR};
+        std::size_t lLen{lpat.length()};
+
+        // Check if #index is inside of the other pattern
+        bool insideOther{
+            (!lKeywordIndex && rKeywordIndex && !lKeyword &&
+             !((set_indexR < leftIndex) || (set_indexR > leftIndex + lLen))) ||
+            (lKeywordIndex && !rKeywordIndex && !rKeyword &&
+             !((set_indexL < rightIndex) || (set_indexL > rightIndex + lLen)))};
+
+        // switch indexes if both set with #index but in wrong order:
+        if ((set_indexL > set_indexR) && (lKeywordIndex && rKeywordIndex))
+            std::swap(set_indexL, set_indexR);
+        if (lKeywordIndex && (set_indexL <= filename.length()))
+            lmatch = true;
+        if (rKeywordIndex && set_indexR <= filename.length())
+            rmatch = true;
+
+        // Make sure both patterns aren't #index with same number
+        if ( lKeywordIndex && rKeywordIndex && (lpat == rpat) )
+            lmatch = false;
+
+        if (!insideOther && lmatch && rmatch)
+            match.matched = (leftIndex != rightIndex) || lKeywordIndex || rKeywordIndex;
+    }
 
-    // Adjust for pattern keywords
-    if (lpat == "#begin")
-        leftIndex = 0;
-    if (rpat == "#begin")
-        rightIndex = 0;
-    if (rpat == "#end" || rpat == "#ext" )
-        rightIndex = path.stem().string().length();
-    if (lpat == "#end" || lpat == "#ext" )
-        leftIndex = path.stem().string().length();
-    if (lKeywordIndex)
-        leftIndex = getIndex(lpat);
-    if (rKeywordIndex)
-        rightIndex = getIndex(rpat);
-
-    if (leftIndex == rightIndex)
-        return "";
+    // Get the text to replace in the new filename
+    {
+        std::size_t leftIndex{foundLeft};
+        std::size_t rightIndex{foundRight};
+        bool lmatch{lKeyword || leftIndex != std::string::npos ||
+                    (lKeywordIndex && indexL <= filename.length())};
+        bool rmatch{rKeyword || rightIndex != std::string::npos ||
+                    (rKeywordIndex && indexR <= filename.length())};
+
+        // Adjust for pattern keywords
+        if (lBegin)
+            leftIndex = 0;
+        if (rBegin)
+            rightIndex = 0;
+        if (rEnd)
+            rightIndex = stemLength;
+        if (lEnd)
+            leftIndex = stemLength;
+        if (lKeywordIndex)
+            leftIndex = indexL;
+        if (rKeywordIndex)
+            rightIndex = indexR;
+
+        if (lmatch && rmatch && leftIndex != rightIndex)
+        {
+            // Switch the pattern indexes if rightmost one is entered first
+            // (plus) check to include patterns to replace
+            if ( leftIndex > rightIndex)
+            {
+                std::swap(leftIndex, rightIndex);
+                if (!lKeywordIndex && !rKeywordIndex)
+                {
+                    if (plus && !lKeyword)
+                        rightIndex += lpat.length();
+                    else if (!rKeyword)
+                        leftIndex += rpat.length();
+                }
+                else if (lKeywordIndex && !rKeywordIndex)
+                    leftIndex += rpat.length();
+            }
+            else if (plus && !rKeywordIndex)
+                rightIndex += rpat.length();
+            else if (!lKeyword && !lKeywordIndex)
+                leftIndex += lpat.length();
+
+            match.eraseStart = leftIndex;
+            match.eraseEnd = rightIndex;
+            match.renamable = leftIndex <= rightIndex && rightIndex <= filename.length();
+        }
+    }
 
-    // Switch the pattern indexes if rightmost one is entered first
-    // (plus) check to include patterns to replace
-    if ( leftIndex > rightIndex)
+    // Get the highlighted parts of the preview
     {
-        std::swap(leftIndex, rightIndex);
-        if (!lKeywordIndex && !rKeywordIndex)
+        std::size_t index{foundLeft};
+        std::size_t index2{foundRight};
+        std::size_t pLength{lpat.length()};
+        std::size_t pLength2{rpat.length()};
+        if (lKeyword || lKeywordIndex)
+        {
+            index = lBegin ? 0 : (lKeywordIndex ? indexL : stemLength);
+            pLength = (lpat == "#ext") ? extLength : 0;
+        }
+        if (rKeyword || rKeywordIndex)
         {
-            if (plus && lpat != "#begin" && lpat != "#end" && lpat != "#ext")
-                rightIndex += lpat.length();
-            else if (rpat != "#begin" && rpat != "#end" && rpat != "#ext")
-                leftIndex += rpat.length();
+            index2 = rBegin ? 0 : (rKeywordIndex ? indexR : stemLength);
+            pLength2 = (rpat == "#ext") ? extLength : 0;
         }
-        else if (lKeywordIndex && !rKeywordIndex)
-            leftIndex += rpat.length();
+        if (index > index2)
+        {
+            std::swap(index, index2);
+            std::swap(pLength, pLength2);
+        }
+        match.index = index;
+        match.length = pLength;
+        match.index2 = index2;
+        match.length2 = pLength2;
     }
-    else if (plus && !rKeywordIndex)
-        rightIndex += rpat.length();
-    else if (lpat != "#begin" && lpat != "#end" && lpat != "#ext" && !lKeywordIndex)
-        leftIndex += lpat.length();
+
+    return match;
+}
+
+
+fs::path getBetweenFilename(const BetweenMatch& match, std::string replacement)
+{
+    if (!match.renamable)
+        return "";
 
     // Handle replacement keyword patterns
     if (replacement == "#begin" || replacement == "#end")
         replacement = "";
     else if (replacement == "#ext")
-        replacement = path.extension().string();
+        replacement = match.path.extension().string();
 
     // Replace ? with digits in replacement pattern
-    if ( (lpatHasQ || rpatHasQ) && replaceHasQ )
-        replacement = replaceDigits(digits, replacement);
+    if ( !match.digits.empty() && replacement.find("?") != std::string::npos )
+        replacement = replaceDigits(match.digits, replacement);
 
     // Edit filename string
-    filename.erase(filename.begin() + leftIndex, filename.begin() + rightIndex);
-    filename.insert(leftIndex, replacement);
+    std::string filename{match.filename};
+    filename.erase(filename.begin() + match.eraseStart, filename.begin() + match.eraseEnd);
+    filename.insert(match.eraseStart, replacement);
 
-    fs::path fullPath{path.parent_path() /= filename};
+    fs::path fullPath{match.path.parent_path() /= filename};
     return fullPath;
 }
 
 
+fs::path getBetweenFilename(const FileRecord& file, 
+                            std::string lpat, std::string rpat,
+                            std::string replacement, bool plus)
+{
+    return getBetweenFilename(matchBetween(file, Pattern{lpat}, Pattern{rpat}, plus),
+                              replacement);
+}
+
+
 
 // Used with splitString to remove spaces from ends of a string
 std::string removeSpace(std::string s)
@@ -617,7 +933,7 @@ std::string removeSpace(std::string s)
 // Returns a vector of a string split along a delimiter
 std::vector<std::string> splitString(const std::string& str, 
                                      const std::string& delimiter, 
-                                     bool removeSpaces = true)
+                                     bool removeSpaces)
 {
     std::vector<std::string> splitLines{};
     std::string s{};
@@ -665,9 +981,9 @@ void printToFile(Filenames& filePaths, std::set<fs::path> directories,
     newFile << '\n';
 
     // Write filenames
-    for (auto& pair: filePaths)
+    for (auto pair : filePaths)
     {
-        newFile << pair.second.filename().string() << separator;
+        newFile << pair.second.filename << separator;
     }
 }
 
@@ -680,12 +996,13 @@ Filenames replaceSubtitleFilenames(Filenames& filePaths, Filenames subtitlePaths
     fs::path newFilename{};
 
     size_t idx{};
-    for (auto& pair : filePaths)
+    for (auto pair : filePaths)
     {
-        if (fs::is_directory(pair.second))
+        if (pair.second.isDirectory)
             continue;
-        newFilename = pair.second.stem().string() + subtitlePaths[idx].extension().string();
-        subtitlePaths[idx].replace_filename(newFilename);
+        newFilename = pair.second.stem() + subtitlePaths[idx].extension();
+        subtitlePaths[idx] = subtitlePaths[idx].renamed(
+            subtitlePaths[idx].path.parent_path() / newFilename);
         ++idx;
         if (idx >= sSize)
             break;
@@ -695,55 +1012,50 @@ Filenames replaceSubtitleFilenames(Filenames& filePaths, Filenames subtitlePaths
 
 
 
-void defaultPrintFilenameWithColor(const fs::path& filePath, std::string pat)
+void defaultPrintFilenameWithColor(const FileRecord& file, const Pattern& pattern)
 {
-    if ( pat.empty() )
+    if ( pattern.pattern.empty() )
         return;
 
     // Convert any ? into digit
-    pat = convertPatternWithRegex(filePath.filename().string(), lowercase(pat));
+    std::string pat{pattern.matchText(file.lowerName)};
 
-    const std::string filename{filePath.filename().string()};
-    fs::path newFile{filePath};
+    const std::string& filename{file.filename};
     std::int16_t set_index{getIndex(pat)};
 
     if (pat == "#begin")
     {
-        setColor(Color::blue);
-        std::cout << "*";
-        resetColor();
-        std::cout << filename << '\n';
+        screen.color(Color::blue) << "*";
+        screen.reset();
+        screen << filename << '\n';
         return;
     }
     else if (pat == "#end")
     {
-        std::cout << filePath.stem().string();
-        setColor(Color::blue);
-        std::cout << "*";
-        resetColor();
-        std::cout << filePath.extension().string() << '\n';
+        screen << file.stem();
+        screen.color(Color::blue) << "*";
+        screen.reset();
+        screen << file.extension() << '\n';
         return;
     }
     else if (pat == "#ext")
     {
-        std::cout << filePath.stem().string();
-        setColor(Color::blue);
-        std::cout << filePath.extension().string() << '\n';
-        resetColor();
+        screen << file.stem();
+        screen.color(Color::blue) << file.extension() << '\n';
+        screen.reset();
         return;
     }
     else if (pat.rfind("#index", 0) == 0)
     {
-        std::cout << filename.substr(0, set_index);
-        setColor(Color::blue);
-        std::cout << "*";
-        resetColor();
-        std::cout << filename.substr(set_index) << '\n';
+        screen << std::string_view{filename}.substr(0, set_index);
+        screen.color(Color::blue) << "*";
+        screen.reset();
+        screen << std::string_view{filename}.substr(set_index) << '\n';
         return;
     }
 
     // Print filename, with each pattern in blue
-    std::string filename_lower{ lowercase(filename) };
+    const std::string& filename_lower{ file.lowerName };
     std::size_t patPos{};
     std::size_t prevEnd{};
     std::size_t whiteLength{};
@@ -751,68 +1063,24 @@ void defaultPrintFilenameWithColor(const fs::path& filePath, std::string pat)
     while( (patPos = filename_lower.find(pat, patPos) ) != std::string::npos )
     {
         whiteLength = patPos - prevEnd;
-        std::cout << filename.substr(prevEnd, whiteLength);
-        setColor(Color::blue);
-        std::cout << filename.substr(patPos, pat.length());
-        resetColor();
+        screen << std::string_view{filename}.substr(prevEnd, whiteLength);
+        screen.color(Color::blue) << std::string_view{filename}.substr(patPos, pat.length());
+        screen.reset();
         prevEnd = patPos + pat.length();
         patPos = prevEnd;
     }
     whiteLength = filename.length() - prevEnd;
-    std::cout << filename.substr(prevEnd, whiteLength) << '\n';
-}
-
-
-// Used with betweenPrintFilenameWithColor
-void adjustForPatternKeywords(const fs::path& filePath, const std::string& pattern, 
-                              size_t& index, size_t& pLength)
-{
-    // std::int16_t set_index1{getIndex(pattern)};
-
-    if (pattern == "#begin")
-    {
-        index = 0;
-        pLength = 0;
-    }
-    else if (pattern == "#end")
-    {
-        index = filePath.stem().string().length();
-        pLength = 0;
-    }
-    else if (pattern == "#ext")
-    {
-        index = filePath.stem().string().length();
-        pLength = filePath.extension().string().length();
-    }
-    else if (pattern.rfind("#index", 0) == 0)
-    {
-        index = getIndex(pattern);
-        pLength = 0;
-    }
+    screen << std::string_view{filename}.substr(prevEnd, whiteLength) << '\n';
 }
 
 
-
-void betweenPrintFilenameWithColor(const fs::path& filePath, std::string pattern1,
-                                std::string pattern2, bool plus)
+void betweenPrintFilenameWithColor(const BetweenMatch& match)
 {   
-    // Convert any ? into digit
-    pattern1 = convertPatternWithRegex(filePath.filename().string(), pattern1);
-    pattern2 = convertPatternWithRegex(filePath.filename().string(), pattern2, true, true);
-
-    std::string filename{filePath.filename().string()};
-    size_t index{lowercase(filename).find(lowercase(pattern1))};
-    size_t index2{lowercase(filename).rfind(lowercase(pattern2))};
-    size_t pLength{pattern1.length()};
-    size_t pLength2{pattern2.length()};
-    adjustForPatternKeywords(filePath, pattern1, index, pLength);
-    adjustForPatternKeywords(filePath, pattern2, index2, pLength2);
-    if (index > index2)
-    {
-        pattern1.swap(pattern2);
-        std::swap(index, index2);
-        std::swap(pLength, pLength2);
-    }
+    const std::string& filename{match.filename};
+    size_t index{match.index};
+    size_t index2{match.index2};
+    size_t pLength{match.length};
+    size_t pLength2{match.length2};
 
     size_t patEnd{index + pLength};
     size_t pat2End{index2 + pLength2};
@@ -821,75 +1089,174 @@ void betweenPrintFilenameWithColor(const fs::path& filePath, std::string pattern
     // If pattern1 not in filename:
     if (index == std::string::npos)
     {
-        std::cout << filename << "\n";
+        screen << filename << "\n";
         return;
     }
 
     // Print the filename
     std::int16_t patternColor{12};
-    if (plus)
+    if (match.plus)
         patternColor = 9;
 
-    std::cout << filename.substr(0, index);            //first part before pat
-    setColor(patternColor);
+    screen << std::string_view{filename}.substr(0, index);            //first part before pat
+    screen.color(patternColor);
     if (pLength == 0)
-        std::cout << "*";
+        screen << "*";
     else
-        std::cout << filename.substr(index, pLength);      //pattern1
+        screen << std::string_view{filename}.substr(index, pLength);      //pattern1
 
     // If pattern2 not in filename:
     if (index2 == std::string::npos)
     {
-        resetColor();
-        std::cout << filename.substr(patEnd) << '\n';
+        screen.reset();
+        screen << std::string_view{filename}.substr(patEnd) << '\n';
         return;
     }
 
     // Print second part
-    setColor(Color::blue);
-    std::cout << filename.substr(patEnd, midLength);    //center of pat
-    setColor(patternColor);
+    screen.color(Color::blue);
+    screen << std::string_view{filename}.substr(patEnd, midLength);    //center of pat
+    screen.color(patternColor);
     if (pLength2 == 0)
-        std::cout << "*";
+        screen << "*";
     else
-        std::cout << filename.substr(index2, pLength2); //pattern2
-    resetColor();
-    std::cout << filename.substr(pat2End) << '\n';      //end of filename
+        screen << std::string_view{filename}.substr(index2, pLength2); //pattern2
+    screen.reset();
+    screen << std::string_view{filename}.substr(pat2End) << '\n';      //end of filename
 }
 
 
-void undoRename(HistoryData& history, std::int16_t index, Filenames& filePaths)
+void undoRename(HistoryData& history, std::vector<std::size_t> indexes, Filenames& filePaths,
+                DirectorySnapshot& snapshot)
 {
-    std::pair<Filenames, Filenames> oldNewFilenames{};
-    oldNewFilenames = history.getFilenames(index);
-    Filenames oldFiles{oldNewFilenames.first};
-    Filenames newFiles{oldNewFilenames.second};
-    
+    // Newest entry first, so a file renamed in several entries gets one rename
+    std::sort(indexes.begin(), indexes.end());
+    indexes.erase(std::unique(indexes.begin(), indexes.end()), indexes.end());
+    std::map<fs::path, fs::path> undo{};                    // Current path -> restored path
+    std::unordered_map<std::string, fs::path> restoredFrom{};
+    std::map<std::size_t, HistoryLog::OldNewFiles> entries{};
+    std::map<fs::path, std::vector<std::pair<std::size_t, fs::path>>> undoneBy{};  // Entry, old path
+    for (std::size_t index : indexes)
+    {
+        entries[index] = history.entry(index);
+        for (auto& [oldPath, newPath] : entries[index])
+        {
+            auto chained{restoredFrom.find(newPath.generic_string())};
+            fs::path current{chained == restoredFrom.end() ? newPath : chained->second};
+            if (chained != restoredFrom.end())
+                restoredFrom.erase(chained);
+            undo[current] = oldPath;
+            undoneBy[current].emplace_back(index, oldPath);
+            restoredFrom[oldPath.generic_string()] = current;
+        }
+    }
+
+    // Check every file at once: it must still exist and its old name be free.
+    // The entries are undone as a whole or not at all.
+    ConflictChecker conflicts{snapshot};
+    std::vector<FileRecord> records{};
+    std::vector<fs::path> oldPaths{};
+    std::set<fs::path> restored{};                          // Current paths back at their old name
+    bool refused{};
     std::cout << '\n';
-    for (auto& pair : oldFiles)
+    for (auto& [current, oldPath] : undo)
+    {
+        if (current == oldPath)
+        {
+            restored.insert(current);
+            continue;
+        }
+        if (!conflicts.exists(current))
+        {
+            redErrorMessage("Cannot undo \"" + current.filename().string() + 
+                            "\" because it has since been changed.", false);
+            refused = true;
+            continue;
+        }
+        // History keeps only paths: folders must be known to move what is inside them
+        std::error_code ec{};
+        records.push_back(FileRecord{current, fs::is_directory(current, ec)});
+        oldPaths.push_back(oldPath);
+    }
+    std::vector<const FileRecord*> recordPtrs{};
+    for (auto& record : records)
+        recordPtrs.push_back(&record);
+    std::vector<std::uint8_t> allowed{conflicts.claimAll(recordPtrs, oldPaths)};
+
+    for (std::size_t pos{}; pos < records.size(); ++pos)
+    {
+        if (!allowed[pos])
+        {
+            redErrorMessage("Cannot undo \"" + records[pos].filename + "\" (Filename \"" + 
+                            oldPaths[pos].filename().string() + "\" already exists.)", false);
+            refused = true;
+        }
+    }
+    if (refused)
     {
-        printFileChange(newFiles[pair.first], pair.second);
+        redErrorMessage("Nothing was undone.");
+        return;
+    }
+
+    Filenames currentFiles{};
+    Filenames restoredFiles{};
+    MenuIndex idx{};
+    for (std::size_t pos{}; pos < records.size(); ++pos)
+    {
+        printFileChange(records[pos].path, oldPaths[pos]);
+        currentFiles[idx] = records[pos];
+        restoredFiles[idx] = records[pos].renamed(oldPaths[pos]);
+        ++idx;
+    }
+
+    if (restoredFiles.empty())
+    {
+        redErrorMessage("Nothing to undo.");
+        return;
     }
 
     // Chance to quit.
-    if ( checkIfQuit(oldFiles.size()) )
+    if ( checkIfQuit(restoredFiles.size()) )
         return;
 
-    // update menu
+    // Rename files, then find their menu slots by path
+    std::unordered_map<std::string, MenuIndex> menuSlots{};
     for (auto pair : filePaths)
+        menuSlots[pair.second.path.generic_string()] = pair.first;
+    Filenames renamedFrom{currentFiles};
+    std::map<fs::path, fs::path> movedDirs{renameAndMenuUpdate(restoredFiles, currentFiles, history,
+                                                               snapshot, false)};
+
+    for (auto pair : restoredFiles)
     {
-        for (auto pair2 : newFiles)
-        {
-            if (pair.second == pair2.second)
-                filePaths[pair.first] = oldFiles[pair2.first];
-        }
+        const fs::path& current{renamedFrom.at(pair.first).path};
+        restored.insert(current);
+        auto slot{menuSlots.find(current.generic_string())};
+        if (slot != menuSlots.end())
+            filePaths[slot->second] = filePaths[slot->second].renamed(pair.second.path);
     }
+    followMovedDirs(filePaths, movedDirs);
 
-    // Rename files.
-    renameAndMenuUpdate(oldFiles, newFiles);
+    // A rename that failed keeps its history: entries lose only the renames undone
+    for (auto& [current, parts] : undoneBy)
+    {
+        if (!restored.contains(current))
+            continue;
+        for (auto& [index, oldPath] : parts)
+            entries[index].erase(oldPath);
+    }
+    for (auto& [index, entry] : entries)
+    {
+        if (!entry.empty() && entry.size() != history.entry(index).size())
+            history.replaceEntry(index, entry);
+    }
 
-    // Remove from history.
-    history.removeEntry(index);
+    // Remove the rest from history (last first, so the other indexes stay the same).
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it)
+    {
+        if (it->second.empty())
+            history.removeEntry(it->first);
+    }
 }
 
 // Used with convertRangeDashes
@@ -920,27 +1287,3 @@ void convertRangeDashes(std::vector<std::string>& indexes)
     }
     indexes.erase(std::remove_if(indexes.begin(), indexes.end(), checkDash), indexes.end() );
 }
-
-
-
-void reloadMenu(Filenames& filePaths, Filenames& filePaths_copy, 
-                std::set<fs::path> directories, const fs::path programName)
-{
-    filePaths = getFilenames(directories, programName);
-    filePaths_copy = filePaths;
-}
-
-
-
-bool checkMapItemUnique(const Filenames& filePaths, fs::path path)
-{
-    for (const auto& pair: filePaths)
-    {
-        if (path == pair.second)
-        {
-            return false;
-        }
-    }
-    return true;
-}
-
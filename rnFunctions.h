@@ -3,17 +3,42 @@
 
 #include <filesystem>
 #include "history.h"
+#include "pattern.h"
 #include <map>
 #include <set>
 #include <string>
 #include <vector>
 #include <cstddef>
+#include <functional>
 
 namespace fs = std::filesystem;
-using Filenames = std::map<int16_t, fs::path>;
 
+class DirectorySnapshot;
+class Pager;
 
 
+
+// Command line batch mode: prompts are answered from the arguments, and the
+// outcome is counted for the exit code
+struct BatchMode
+{
+    bool active{};
+    bool confirm{};                       // --yes: rename instead of only previewing
+    std::vector<std::string> answers{};   // Given to prompts in order
+    std::size_t nextAnswer{};
+    std::size_t planned{};                // Renames that passed the conflict check
+    std::size_t renamed{};
+    std::size_t failed{};
+    std::size_t skipped{};                // Files left out (name conflicts)
+    std::size_t errors{};                 // Error messages (skipped files included)
+};
+
+extern BatchMode batchMode;
+
+// Show the prompt and read one line from the user, or take the next answer
+// (without the prompt) in batch mode
+std::string readInput(std::string_view prompt = "");
+
 void redErrorMessage(std::string_view s, bool pause = true);
 
 // Replaces all instances of a pattern with a new pattern
@@ -24,7 +49,7 @@ std::string strReplaceAll(std::string origin, const std::string& pat,
 void convertRangeDashes(std::vector<std::string>& indexes);
 
 // converts #^ pattern into number
-std::string convertSequenceNumber(std::string& pattern, std::int16_t indexNum, 
+std::string convertSequenceNumber(std::string& pattern, std::size_t indexNum, 
                                   size_t numOfFiles);
 
 std::string lowercase(std::string s);
@@ -33,10 +58,23 @@ void toLowercase(std::string& s);
 
 void capitalize(std::string& s);
 
-void renameAndMenuUpdate(Filenames& newPaths, Filenames& oldPaths);
+// Rename files concurrently under the journal, then update history (if record)
+// and the menu with the ones that worked. Returns the renamed directories
+// (old path -> new path); paths inside them are updated in the menu too.
+std::map<fs::path, fs::path> renameAndMenuUpdate(Filenames& newPaths, Filenames& oldPaths,
+                                                 HistoryData& history, DirectorySnapshot& snapshot,
+                                                 bool record = true);
 
-// make a regex string with ? converted to [0-9]
-std::string makeRegex(const std::string& pattern);
+// Path after the directories above it were renamed
+fs::path movedPath(const fs::path& path, const std::map<fs::path, fs::path>& movedDirs);
+
+// Move menu paths inside renamed directories to the directories' new names
+void followMovedDirs(Filenames& files, const std::map<fs::path, fs::path>& movedDirs);
+
+// Every directory under dirs, depth levels down (0: no limit). Folders
+// whose name matches skip are left out with everything under them.
+std::set<fs::path> getSubdirectories(const std::set<fs::path>& dirs, std::size_t depth,
+                                     const std::string& skip = "");
 
 // For ? inside replacement pattern, return all the digits in first pat to use
 std::vector<std::string> extractDigits(const std::string& filename, const std::string& pattern);
@@ -44,9 +82,19 @@ std::vector<std::string> extractDigits(const std::string& filename, const std::s
 // For ? inside replacement pattern, replace digits in replacement
 std::string replaceDigits(const std::vector<std::string>& digits, std::string pat);
 
-// Print: old filename ---> new filename
+// Print: old filename ---> new filename. Kept for the rename preview,
+// which checkIfQuit shows a page at a time.
 void printFileChange(const fs::path& oldPath, const fs::path& newPath);
 
+// Add a file left out of the renames (name conflict) to the rename preview
+void printSkippedFile(std::string_view message);
+
+// Forget a rename preview that wasn't shown by checkIfQuit
+void clearRenamePreview();
+
+// Print counts (matches, conflicts...) and which page of a list is shown
+void printPageSummary(const Pager& pager, std::string_view counts);
+
 // bool check for pattern, converting ? into any number
 bool checkPatternWithRegex(const std::string& filename, const std::string& pattern);
 
@@ -54,40 +102,75 @@ bool checkPatternWithRegex(const std::string& filename, const std::string& patte
 std::string convertPatternWithRegex(std::string filename, std::string pattern,
                                     bool lower = true, bool right = false);
 
+// Same as above, reusing an already compiled pattern
+std::string convertPatternWithRegex(const std::string& filename, const Pattern& pattern,
+                                    bool right = false);
+
 // Checks if map is empty and prints message if it is
 bool checkForMatches(const Filenames& matchedPaths);
 
-// Print number of matches and ask for second pattern
+// Print number of matches and the rename preview, paging through it until
+// the user renames (ENTER) or quits
 bool checkIfQuit(std::size_t index);
 
-// Takes a path and removes the extension and dot at start
-void removeDotEnds(fs::path& file, bool& dotAtStart);
+// Returns the filename without the extension and dot at start
+std::string removeDotEnds(const FileRecord& file, bool& dotAtStart);
 
 // Restors the extension and dot at start
-void restoreDotEnds(fs::path& newFile, const fs::path& file, 
+void restoreDotEnds(std::string& newFilename, const FileRecord& file, 
                     bool dotAtStart);
 
+// Filename with dots replaced by spaces (keeping the extension and a dot
+// prefix), empty if there are no dots to replace
+std::string replaceDots(const FileRecord& file);
+
+// Whether the search pattern (or #begin, #end, #ext, #index) matches a filename
+bool patternMatches(const FileRecord& file, const std::string& pattern,
+                    const Pattern& compiledPattern, std::int16_t index);
+
 // Used with #index keyword
 std::int16_t getIndex(const std::string& pattern);
 
 // Rename a file using given two patterns
-fs::path renameFile(fs::path filePath, const std::string& pat, 
+fs::path renameFile(const FileRecord& file, const std::string& pat, 
                     std::string newPat);
 
-// Rename a file given full paths
-bool renameErrorCheck(fs::path path, fs::path new_path);
+// Runs task(0 ... count-1) on a bounded pool of worker threads
+// (0 workers: one per core). The first exception is rethrown after all finish.
+void parallelFor(std::size_t count, const std::function<void(std::size_t)>& task,
+                 std::size_t maxWorkers = 0);
 
 // Returns a <map> of filenames in a given directory
 Filenames getFilenames(const std::set<fs::path>& dirs, fs::path programName = "none");
 
-// Print filenames for menu
-void printFilenames(const Filenames& paths, 
-                    const bool showNums=false);
-
-bool checkBetweenMatches(const fs::path& path, 
-                         std::string lpat, std::string rpat);
-
-fs::path getBetweenFilename(const fs::path& path, 
+// Print the menu page, with the number of filenames (and removed ones)
+void printFilenames(const Filenames& paths, const Pager& pager,
+                    const bool showNums=false, std::size_t removed = 0);
+
+// Everything needed to preview, check and rename one filename with between
+struct BetweenMatch
+{
+    fs::path path{};
+    std::string filename{};
+    std::vector<std::string> digits{};  // For ? inside replacement pattern
+    bool plus{};
+    bool matched{};                     // Shown in preview and counted
+    bool renamable{};                   // A new filename can be made
+    std::size_t eraseStart{};           // Text replaced in new filename
+    std::size_t eraseEnd{};
+    std::size_t index{};                // Patterns highlighted in preview
+    std::size_t length{};
+    std::size_t index2{};
+    std::size_t length2{};
+};
+
+// Match both patterns once, resolving #begin, #end, #ext and #index
+BetweenMatch matchBetween(const FileRecord& file, const Pattern& lpattern,
+                          const Pattern& rpattern, bool plus);
+
+fs::path getBetweenFilename(const BetweenMatch& match, std::string replacement);
+
+fs::path getBetweenFilename(const FileRecord& file, 
                           std::string lpat, std::string rpat,
                           std::string replacement, bool plus);
 
@@ -107,16 +190,12 @@ void printToFile(Filenames& filePaths, std::set<fs::path> directories,
 
 Filenames replaceSubtitleFilenames(Filenames& filePaths, Filenames subtitlePaths);
 
-void defaultPrintFilenameWithColor(const fs::path& filePath, std::string pat);
-
-void betweenPrintFilenameWithColor(const fs::path& filePath, std::string pattern1,
-                                std::string pattern2, bool plus);
-
-void undoRename(HistoryData& history, std::int16_t index, Filenames& filePaths);
+void defaultPrintFilenameWithColor(const FileRecord& file, const Pattern& pattern);
 
-bool checkMapItemUnique(const Filenames& filePaths, fs::path path);
+void betweenPrintFilenameWithColor(const BetweenMatch& match);
 
-void reloadMenu(Filenames& filePaths, Filenames& filePaths_copy, 
-                std::set<fs::path> directories, const fs::path programName);
+// Undo history entries (newest first) as one batch of renames
+void undoRename(HistoryData& history, std::vector<std::size_t> indexes, Filenames& filePaths,
+                DirectorySnapshot& snapshot);
 
 #endif
\ No newline at end of file
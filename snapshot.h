@@ -0,0 +1,281 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "rnFunctions.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <string>
+#include <system_error>
+#include <vector>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+
+
+// Every entry of the working directories, scanned once and then kept
+// current from change events. Indices stay the same until the next reload.
+class DirectorySnapshot
+{
+public:
+    Filenames files{};
+    std::set<fs::path> directories{};
+    fs::path programName{};
+
+private:
+    std::map<fs::path, MenuIndex> indexes{};
+#ifdef __linux__
+    int inotifyFd{-1};
+    std::map<int, fs::path> watches{};
+#else
+    std::map<fs::path, fs::file_time_type> writeTimes{};
+#endif
+
+public:
+    DirectorySnapshot(const fs::path& program)
+        {
+            programName = program;
+#ifdef __linux__
+            inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+        }
+
+    ~DirectorySnapshot()
+        {
+#ifdef __linux__
+            if (inotifyFd >= 0)
+                close(inotifyFd);
+#endif
+        }
+
+    DirectorySnapshot(const DirectorySnapshot&) = delete;
+    DirectorySnapshot& operator=(const DirectorySnapshot&) = delete;
+
+    // Full scan, numbering entries from 0
+    void reload(const std::set<fs::path>& dirs)
+    {
+        unwatchAll();
+        directories = dirs;
+        files = getFilenames(directories, programName);
+        indexes.clear();
+        for (auto pair : files)
+            indexes[pair.second.path] = pair.first;
+
+        for (auto& dir : directories)
+            watch(dir);
+    }
+
+    // Apply changes made since the last call, without rescanning
+    const Filenames& update()
+    {
+#ifdef __linux__
+        if (inotifyFd < 0)
+        {
+            for (auto& dir : directories)
+                resync(dir);
+            return files;
+        }
+
+        alignas(inotify_event) char buffer[16384];
+        std::map<std::uint32_t, fs::path> movedFrom{};
+        std::set<fs::path> lostDirs{};
+        bool overflow{};
+        ssize_t length{};
+        while ( (length = read(inotifyFd, buffer, sizeof(buffer))) > 0 )
+        {
+            for (char* ptr{buffer}; ptr < buffer + length; )
+            {
+                const inotify_event* event{reinterpret_cast<inotify_event*>(ptr)};
+                ptr += sizeof(inotify_event) + event->len;
+
+                if (event->mask & IN_Q_OVERFLOW)
+                {
+                    overflow = true;
+                    continue;
+                }
+                auto watched{watches.find(event->wd)};
+                if (watched == watches.end())
+                    continue;
+
+                if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+                {
+                    lostDirs.insert(watched->second);
+                    continue;
+                }
+                if (!event->len)
+                    continue;
+
+                fs::path path{watched->second / event->name};
+                if (event->mask & IN_MOVED_FROM)
+                    movedFrom[event->cookie] = path;
+                else if (event->mask & IN_MOVED_TO && movedFrom.contains(event->cookie))
+                {
+                    move(movedFrom[event->cookie], path);
+                    movedFrom.erase(event->cookie);
+                }
+                else if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                    add(FileRecord{path, (event->mask & IN_ISDIR) != 0});
+                else if (event->mask & IN_DELETE)
+                    remove(path);
+            }
+        }
+
+        // Moved out of the working directories
+        for (auto& pair : movedFrom)
+            remove(pair.second);
+
+        if (overflow)
+        {
+            for (auto& dir : directories)
+                resync(dir);
+        }
+        else
+        {
+            for (auto& dir : lostDirs)
+                resync(dir);
+        }
+#else
+        // Only rescan directories whose contents changed
+        std::error_code ec{};
+        for (auto& dir : directories)
+        {
+            fs::file_time_type writeTime{fs::last_write_time(dir, ec)};
+            if (ec || writeTime != writeTimes[dir])
+                resync(dir);
+        }
+#endif
+        return files;
+    }
+
+    // Directories renamed by the program (old path -> new path). Paths under
+    // them follow; the renamed entries themselves come in as changes.
+    void moveDirectories(const std::map<fs::path, fs::path>& movedDirs)
+    {
+        if (movedDirs.empty())
+            return;
+        auto follow = [&](const fs::path& path)
+        {
+            auto moved{movedDirs.find(path)};
+            return moved != movedDirs.end() ? moved->second : movedPath(path, movedDirs);
+        };
+
+        std::set<fs::path> dirs{};
+        for (auto& dir : directories)
+            dirs.insert(follow(dir));
+        directories = dirs;
+#ifdef __linux__
+        for (auto& pair : watches)
+            pair.second = follow(pair.second);
+#else
+        std::map<fs::path, fs::file_time_type> times{};
+        for (auto& pair : writeTimes)
+            times[follow(pair.first)] = pair.second;
+        writeTimes = times;
+#endif
+
+        std::map<fs::path, MenuIndex> moved{};
+        for (auto& pair : indexes)
+        {
+            fs::path path{movedPath(pair.first, movedDirs)};
+            if (path != pair.first)
+                files[pair.second] = files[pair.second].renamed(path);
+            moved[path] = pair.second;
+        }
+        indexes = moved;
+    }
+
+private:
+    void watch(const fs::path& dir)
+    {
+#ifdef __linux__
+        if (inotifyFd < 0)
+            return;
+        int wd{inotify_add_watch(inotifyFd, dir.c_str(),
+                                 IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                 IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)};
+        if (wd >= 0)
+            watches[wd] = dir;
+#else
+        std::error_code ec{};
+        writeTimes[dir] = fs::last_write_time(dir, ec);
+#endif
+    }
+
+    void unwatchAll()
+    {
+#ifdef __linux__
+        for (auto& pair : watches)
+            inotify_rm_watch(inotifyFd, pair.first);
+        watches.clear();
+
+        // Drop events still queued for the old directories
+        char buffer[16384];
+        while (inotifyFd >= 0 && read(inotifyFd, buffer, sizeof(buffer)) > 0) {}
+#else
+        writeTimes.clear();
+#endif
+    }
+
+    void add(const FileRecord& record)
+    {
+        if (record.path == programName || indexes.contains(record.path))
+            return;
+        indexes[record.path] = files.push_back(record);
+    }
+
+    void remove(const fs::path& path)
+    {
+        auto found{indexes.find(path)};
+        if (found == indexes.end())
+            return;
+        files.erase(found->second);
+        indexes.erase(found);
+    }
+
+    // Renamed inside the working directories: keep the same index
+    void move(const fs::path& oldPath, const fs::path& newPath)
+    {
+        auto found{indexes.find(oldPath)};
+        if (found == indexes.end())
+        {
+            std::error_code ec{};
+            add(FileRecord{newPath, fs::is_directory(newPath, ec)});
+            return;
+        }
+        MenuIndex index{found->second};
+        indexes.erase(found);
+        files[index] = files[index].renamed(newPath);
+        indexes[newPath] = index;
+    }
+
+    // Compare one directory with the snapshot and apply the difference
+    void resync(const fs::path& dir)
+    {
+        std::map<fs::path, FileRecord> current{};
+        std::error_code ec{};
+        for (fs::directory_iterator it{dir, ec}, end{}; !ec && it != end; it.increment(ec))
+            current[it->path()] = FileRecord{*it};
+
+        std::vector<fs::path> removed{};
+        for (auto& pair : indexes)
+        {
+            if (pair.first.parent_path() == dir && !current.contains(pair.first))
+                removed.push_back(pair.first);
+        }
+        for (auto& path : removed)
+            remove(path);
+        for (auto& pair : current)
+            add(pair.second);
+#ifndef __linux__
+        writeTimes[dir] = fs::last_write_time(dir, ec);
+#endif
+    }
+};
+
+#endif
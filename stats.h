@@ -0,0 +1,178 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+// Phases of a command. Each one adds up wall time, items handled (files,
+// names, rows, entries), filesystem calls made and bytes read or written.
+enum class Phase
+{
+    scan,       // Listing directories
+    match,      // Matching patterns and making new names
+    preview,    // Formatting and writing previews and the menu
+    conflicts,  // Checking new names against existing ones
+    rename,     // Renaming and the rename journal
+    history,    // History log reads and writes
+    count
+};
+
+
+
+// Per-phase breakdown of the last command and totals for the session
+// (!stats). Counts may be added from any thread.
+class Stats
+{
+public:
+    struct Counter
+    {
+        double seconds{};
+        std::uint64_t items{};
+        std::uint64_t calls{};
+        std::uint64_t bytes{};
+    };
+
+    static constexpr std::size_t phaseCount{static_cast<std::size_t>(Phase::count)};
+    static constexpr std::array<const char*, phaseCount> phaseNames{
+        "scan", "match", "preview", "conflicts", "rename", "history"};
+
+private:
+    mutable std::mutex statsMutex{};
+    std::array<Counter, phaseCount> last{};
+    std::array<Counter, phaseCount> total{};
+    std::string command{};
+    std::uint64_t commands{};
+
+public:
+    // A new command: its phases start from zero
+    void begin(std::string_view name)
+    {
+        std::lock_guard<std::mutex> lock{statsMutex};
+        last = {};
+        command = name;
+        ++commands;
+    }
+
+    void add(Phase phase, double seconds, std::uint64_t items,
+             std::uint64_t calls = 0, std::uint64_t bytes = 0)
+    {
+        std::lock_guard<std::mutex> lock{statsMutex};
+        for (auto* counters : {&last, &total})
+        {
+            Counter& counter{(*counters)[static_cast<std::size_t>(phase)]};
+            counter.seconds += seconds;
+            counter.items += items;
+            counter.calls += calls;
+            counter.bytes += bytes;
+        }
+    }
+
+    // Filesystem calls (and bytes) made inside a timed phase
+    void count(Phase phase, std::uint64_t calls, std::uint64_t bytes = 0)
+    {
+        add(phase, 0, 0, calls, bytes);
+    }
+
+    // Table of the last command and the session totals
+    std::string table() const
+    {
+        std::lock_guard<std::mutex> lock{statsMutex};
+        std::ostringstream out{};
+        auto print = [&out](const std::array<Counter, phaseCount>& counters)
+        {
+            char line[128]{};
+            std::snprintf(line, sizeof(line), "%-10s %12s %10s %10s %14s\n",
+                          "Phase", "Time (ms)", "Items", "FS calls", "Bytes");
+            out << line;
+            for (std::size_t idx{}; idx < phaseCount; ++idx)
+            {
+                const Counter& counter{counters[idx]};
+                std::snprintf(line, sizeof(line), "%-10s %12.3f %10llu %10llu %14llu\n", phaseNames[idx],
+                              counter.seconds * 1e3, static_cast<unsigned long long>(counter.items),
+                              static_cast<unsigned long long>(counter.calls),
+                              static_cast<unsigned long long>(counter.bytes));
+                out << line;
+            }
+        };
+        out << "Last command: " << (command.empty() ? "(none)" : command) << '\n';
+        print(last);
+        out << "\nSession (" << commands << " commands):\n";
+        print(total);
+        return out.str();
+    }
+
+    std::string json() const
+    {
+        std::lock_guard<std::mutex> lock{statsMutex};
+        std::ostringstream out{};
+        auto print = [&out](const std::array<Counter, phaseCount>& counters)
+        {
+            out << "{";
+            for (std::size_t idx{}; idx < phaseCount; ++idx)
+            {
+                const Counter& counter{counters[idx]};
+                out << (idx ? ", " : "") << '"' << phaseNames[idx] << "\": {\"ms\": " << counter.seconds * 1e3
+                    << ", \"items\": " << counter.items << ", \"calls\": " << counter.calls
+                    << ", \"bytes\": " << counter.bytes << '}';
+            }
+            out << "}";
+        };
+        std::string name{};
+        for (char c : command)
+        {
+            if (c == '"' || c == '\\')
+                name += '\\';
+            if (static_cast<unsigned char>(c) >= 0x20)
+                name += c;
+        }
+        out << "{\n  \"last\": {\"command\": \"" << name << "\", \"phases\": ";
+        print(last);
+        out << "},\n  \"session\": {\"commands\": " << commands << ", \"phases\": ";
+        print(total);
+        out << "}\n}\n";
+        return out.str();
+    }
+};
+
+inline Stats stats{};
+
+
+
+// Times a scope (or up to stop()) and adds it to a phase
+class PhaseTimer
+{
+    Phase phase{};
+    std::chrono::steady_clock::time_point start{};
+    bool running{true};
+
+public:
+    std::uint64_t items{};
+    std::uint64_t calls{};
+    std::uint64_t bytes{};
+
+    explicit PhaseTimer(Phase timedPhase, std::uint64_t itemCount = 0)
+        : phase{timedPhase}, start{std::chrono::steady_clock::now()}, items{itemCount} {}
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+    ~PhaseTimer() { stop(); }
+
+    void stop()
+    {
+        if (!running)
+            return;
+        running = false;
+        std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+        stats.add(phase, elapsed.count(), items, calls, bytes);
+    }
+};
+
+#endif
@@ -0,0 +1,220 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "chain.h"
+#include "history.h"
+#include "rnFunctions.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+
+
+// Renames the entries of huge directories a chunk at a time: each chunk is
+// read, run through the chain, checked and renamed before the next is read.
+//
+// Names from later chunks aren't known yet, so a new name is checked on
+// disk when its chunk is renamed (earlier chunks are already there). A new
+// name held by a later chunk is refused rather than waited for.
+//
+// Files renamed here can be listed again by the same scan. Most chains leave
+// a new name alone (!lower, x -> y), so nothing needs remembering. A new name
+// the chain would change again is kept until the directory is done, so the
+// file isn't renamed twice. That is the only memory that grows with the
+// directory, and it stops at maxTracked names: past it, such files are
+// skipped (and reported) instead.
+class StreamRenamer
+{
+    static constexpr std::size_t chunkSize{4096};
+    static constexpr std::size_t maxTracked{1 << 20};
+
+    const RenameChain& chain;
+    HistoryData& history;
+    fs::path programName{};
+    bool confirm{};
+    std::unordered_set<std::string> tracked{};      // New names the chain would change again
+
+public:
+    StreamRenamer(const RenameChain& renameChain, HistoryData& historyData,
+                  const fs::path& program, bool rename)
+        : chain{renameChain}, history{historyData}
+        {
+            programName = program;
+            confirm = rename;
+        }
+
+    // Rename the entries of one directory. For a tree, run the deepest
+    // directories first so files are renamed before their folders.
+    void run(const fs::path& dir)
+    {
+        std::error_code ec{};
+        fs::directory_iterator it{dir, ec};
+        if (ec)
+        {
+            redErrorMessage("Cannot read " + dir.string() + " (" + ec.message() + ")", false);
+            return;
+        }
+
+        tracked.clear();
+        std::vector<FileRecord> chunk{};
+        chunk.reserve(chunkSize);
+        for (fs::directory_iterator end{}; !ec && it != end; it.increment(ec))
+        {
+            if (it->path() == programName || tracked.contains(it->path().generic_string()))
+                continue;
+            chunk.emplace_back(*it);
+            if (chunk.size() == chunkSize)
+            {
+                renameChunk(chunk);
+                chunk.clear();
+            }
+        }
+        renameChunk(chunk);
+    }
+
+private:
+    void renameChunk(const std::vector<FileRecord>& chunk)
+    {
+        std::vector<FileRecord> newRecords{chain.apply(chunk)};
+        std::vector<std::size_t> changed{};
+        for (std::size_t pos{}; pos < chunk.size(); ++pos)
+        {
+            if (newRecords[pos].path != chunk[pos].path)
+                changed.push_back(pos);
+        }
+        if (changed.empty())
+            return;
+
+        // A name taken on disk is free if its file is renamed in this chunk
+        std::unordered_map<std::string, std::size_t> sources{};
+        for (std::size_t num{}; num < changed.size(); ++num)
+            sources[key(chunk[changed[num]].path)] = num;
+        std::vector<std::uint8_t> allowed(changed.size(), 1);
+        std::vector<std::size_t> holder(changed.size(), changed.size());
+        std::unordered_set<std::string> targets{};
+        for (std::size_t num{}; num < changed.size(); ++num)
+        {
+            const FileRecord& record{chunk[changed[num]]};
+            const fs::path& target{newRecords[changed[num]].path};
+            std::string targetKey{key(target)};
+            std::error_code ec{};
+            if (!targets.insert(targetKey).second)
+                allowed[num] = 0;
+            else if (targetKey != key(record.path) && fs::exists(target, ec))
+            {
+                // Taken by another file, unless a case-insensitive mount finds the file itself
+                auto owner{sources.find(targetKey)};
+                if (owner == sources.end())
+                    allowed[num] = fs::equivalent(record.path, target, ec);
+                else
+                    holder[num] = owner->second;
+            }
+        }
+
+        // A new name the chain would change again has to be remembered
+        std::vector<FileRecord> produced{};
+        for (std::size_t pos : changed)
+            produced.push_back(newRecords[pos]);
+        std::vector<FileRecord> again{chain.apply(produced)};
+        std::vector<std::uint8_t> track(changed.size());
+        std::vector<std::uint8_t> untracked(changed.size());
+        std::size_t tracking{tracked.size()};
+        for (std::size_t num{}; num < changed.size(); ++num)
+        {
+            if (!allowed[num] || again[num].path == produced[num].path)
+                continue;
+            if (tracking < maxTracked)
+            {
+                track[num] = 1;
+                ++tracking;
+            }
+            else
+            {
+                allowed[num] = 0;
+                untracked[num] = 1;
+            }
+        }
+
+        // Refusing a file keeps its name taken for whoever wanted it
+        for (bool again{true}; again; )
+        {
+            again = false;
+            for (std::size_t num{}; num < changed.size(); ++num)
+            {
+                if (allowed[num] && holder[num] < changed.size() && !allowed[holder[num]])
+                {
+                    allowed[num] = 0;
+                    again = true;
+                }
+            }
+        }
+
+        std::vector<RenameJournal::Rename> renames{};
+        std::vector<std::uint8_t> renameTracked{};
+        for (std::size_t num{}; num < changed.size(); ++num)
+        {
+            const FileRecord& record{chunk[changed[num]]};
+            const FileRecord& newRecord{newRecords[changed[num]]};
+            if (untracked[num])
+            {
+                printSkippedFile("Cannot rename " + record.filename + " (\"" + newRecord.filename +
+                                "\" would be renamed again, too many such names to track.)");
+                continue;
+            }
+            if (!allowed[num])
+            {
+                printSkippedFile("Cannot rename " + record.filename + " (Filename \"" +
+                                newRecord.filename + "\" already exists.)");
+                continue;
+            }
+            printFileChange(record.path, newRecord.path);
+            renames.emplace_back(record.path, newRecord.path);
+            renameTracked.push_back(track[num]);
+        }
+        screen.flush();
+        batchMode.planned += renames.size();
+        if (!confirm || renames.empty())
+            return;
+
+        // Each chunk is renamed (and saved to history) on its own
+        std::vector<std::error_code> results{history.journal.run(renames)};
+        HistoryLog::OldNewFiles historyUpdate{};
+        for (std::size_t pos{}; pos < renames.size(); ++pos)
+        {
+            if (results[pos])
+            {
+                fs::filesystem_error error{"cannot rename", renames[pos].first,
+                                           renames[pos].second, results[pos]};
+                redErrorMessage(error.what(), false);
+                ++batchMode.failed;
+                continue;
+            }
+            if (renameTracked[pos])
+                tracked.insert(renames[pos].second.generic_string());
+            historyUpdate[renames[pos].first] = renames[pos].second;
+            ++batchMode.renamed;
+        }
+        if (history.saveHistory)
+            history.add(historyUpdate);
+    }
+
+    // Names are compared the way the filesystem does
+    static std::string key(const fs::path& path)
+    {
+#ifdef _WIN32
+        return lowercase(path.generic_string());
+#else
+        return path.generic_string();
+#endif
+    }
+};
+
+#endif
@@ -0,0 +1,35 @@
+#!/bin/sh
+# Renaming Foo.txt to foo.txt never overwrites a different foo.txt.
+# Usage: case_conflict.sh RENAMEC
+renamec=$1
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+status=0
+
+# check NAME ARGS...: run renamec on Foo.txt + foo.txt, both must be left.
+# Without ARGS the commands are typed at the menu.
+check()
+{
+    name=$1
+    shift
+    rm -rf "$work"/*
+    echo upper > "$work/Foo.txt"
+    echo lower > "$work/foo.txt"
+    if [ $# -eq 0 ]; then
+        (cd "$work" && printf '!lower\n\n\nq\n' | "$renamec" > /dev/null)
+    else
+        "$renamec" --dir "$work" "$@" --yes > /dev/null
+    fi
+    if [ "$(cat "$work/Foo.txt" 2>/dev/null)" != upper ] ||
+       [ "$(cat "$work/foo.txt" 2>/dev/null)" != lower ]; then
+        echo "$name: a file was overwritten"
+        status=1
+    fi
+}
+
+check chain --chain '!lower'
+check find --find Foo --replace foo
+check stream --stream --chain '!lower'
+check menu
+
+exit $status
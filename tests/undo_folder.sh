@@ -0,0 +1,22 @@
+#!/bin/sh
+# Undoing a folder rename moves the files inside it and the working
+# directory back: a file in the folder can be renamed right after.
+# Usage: undo_folder.sh RENAMEC
+set -e
+renamec=$1
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+mkdir "$work/dirA"
+echo x > "$work/dirA/fileX.txt"
+
+# adir+, rename dirA -> dirB, !undo, !pwd, rename fileX -> fileY
+output=$(cd "$work" && printf 'adir+\n\ndirA\ndirB\n\n!undo\n\n!pwd\n\nfileX\nfileY\n\nq\n' | "$renamec")
+
+if [ ! -f "$work/dirA/fileY.txt" ] || [ -e "$work/dirB" ]; then
+    echo "Files after the undo:"; find "$work"
+    exit 1
+fi
+if echo "$output" | grep -q "$work/dirB\$\|cannot rename"; then
+    echo "$output"
+    exit 1
+fi
@@ -1,11 +1,16 @@
-#include "Colors.h"
+#include "colors.h"
+#include "rnFunctions.h"
+#include "textscan.h"
+#include "wordtable.h"
 #include <algorithm>
 #include <cstdint>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
-#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <vector>
 
 namespace fs = std::filesystem;
@@ -13,127 +18,116 @@ namespace fs = std::filesystem;
 class TextCount
 {
 public:
-    std::vector<fs::path> pathNames{};
-    std::int64_t lineCount{}; // total lines including blank lines
-    std::int64_t blankLineCount{};
-    std::int64_t wordCount{};
-    std::int64_t charCount{};
-    std::map<fs::path, std::int64_t> pathCharCounts{};
-    std::map<fs::path, std::int64_t> pathWordCounts{};
-    std::map<fs::path, std::int64_t> pathLineCounts{};
-    std::map<fs::path, std::int64_t> pathBlankLineCounts{};
+    struct PathCounts
+    {
+        fs::path path{};
+        TextCounts counts{};
+    };
+    std::vector<PathCounts> pathCounts{};      // Menu order, directories left out
+    TextCounts totals{};
 
 private:
-    std::map<std::string, std::int64_t> wordListWithCounts{};
-    std::vector<std::pair<std::string, std::int64_t>> wordListWithCounts_Pairs{};
-    // std::string comepleteText{};
+    WordTable words{};
 
 public:
+    // Files are mapped into memory and counted on a pool of worker threads.
+    // Files larger than chunkSize are split after newlines into chunks that
+    // are counted apart (textscan.h). Each chunk's words are merged into the
+    // table as soon as it is counted, so only the busy chunks hold their own.
+    static constexpr std::size_t chunkSize{1 << 20};
+
     TextCount(std::vector<fs::path>& paths)
     {
-        pathNames = paths;
-        std::string word{};
-        std::string line{};
-        char character{};
-        int32_t idx{};
         for (const auto& path : paths)
         {
-            if (fs::is_directory(path))
-            {
-                pathNames.erase(pathNames.begin() + idx);
+            std::error_code ec{};
+            if (!fs::is_directory(path, ec))
+                pathCounts.push_back({path});
+        }
+
+        std::vector<std::unique_ptr<MappedFile>> files(pathCounts.size());
+        parallelFor(pathCounts.size(), [&](std::size_t idx)
+        {
+            files[idx] = std::make_unique<MappedFile>(pathCounts[idx].path);
+        });
+
+        struct Chunk
+        {
+            std::size_t file{};
+            std::string_view text{};
+            TextCounts counts{};
+        };
+        std::vector<Chunk> chunks{};
+        for (std::size_t idx{}; idx < files.size(); ++idx)
+        {
+            if (!files[idx]->isOpen())
                 continue;
-            }
-            std::ifstream fileData{};
-            fileData.open(path, std::ios::in);
+            for (auto text : splitText(files[idx]->text(), chunkSize))
+                chunks.push_back({idx, text});
+        }
 
-            if ( fileData.is_open() )
-            {
-                while(getline(fileData, line))
-                {
-                    if (line == "")
-                    {
-                        ++blankLineCount;
-                        ++pathBlankLineCounts[path];
-                        // continue;
-                    }
-                    ++lineCount;
-                    ++pathLineCounts[path];
-                    // if (comepleteText != "")
-                    //     comepleteText += '\n';
-                    // comepleteText += line;
-                    std::stringstream stream(line);
-                    while (stream >> word)
-                    {
-                        ++wordCount;
-                        ++pathWordCounts[path];
-                        ++wordListWithCounts[word];
-                        for (char ch : word)
-                        {
-                            if (std::isalpha(ch) || std::ispunct(ch))
-                            {
-                                ++charCount;
-                                ++pathCharCounts[path];
-                            }
-                        }
-                    }
-                }
-                fileData.close();
-            }
-            else
+        std::mutex wordsMutex{};
+        parallelFor(chunks.size(), [&](std::size_t idx)
+        {
+            Chunk& chunk{chunks[idx]};
+            WordTable chunkWords{};
+            chunk.counts = countText(chunk.text, [&chunkWords](std::string_view word)
             {
-                std::cout << "Error opening file: " << path << '\n';
-            }
-        ++idx;
+                chunkWords.add(word);
+            });
+            std::lock_guard<std::mutex> lock{wordsMutex};
+            words.merge(chunkWords);
+        });
+
+        for (auto& chunk : chunks)
+            pathCounts[chunk.file].counts += chunk.counts;
+        for (std::size_t idx{}; idx < files.size(); ++idx)
+        {
+            if (!files[idx]->isOpen())
+                std::cout << "Error opening file: " << pathCounts[idx].path << '\n';
+            totals += pathCounts[idx].counts;
         }
-        // Duplicate map list of words into vector to sort by value
-        for (auto itr = wordListWithCounts.begin(); itr != wordListWithCounts.end(); ++itr)
-            wordListWithCounts_Pairs.push_back(*itr);
-        std::sort(wordListWithCounts_Pairs.begin(), 
-                  wordListWithCounts_Pairs.end(), 
-                  [=](std::pair<std::string, std::int64_t>& a, std::pair<std::string, std::int64_t>& b)
-                     {return a.second > b.second;});
     }
 
 
 
     void printInfo()
     {
-        for (const auto path: pathNames)
+        for (const auto& [path, counts] : pathCounts)
         {
             setColor(Color::green);
             std::cout << "Filename: " << path.filename().string() << '\n';
             resetColor();
-            std::cout << "Lines:          " << pathLineCounts[path] << '\n';
-            std::cout << "Blank lines:    " << pathBlankLineCounts[path] << '\n';
-            std::cout << "Words:          " << pathWordCounts[path] << '\n';
-            std::cout << "Characters:     " << pathCharCounts[path] << '\n';
+            std::cout << "Lines:          " << counts.lines << '\n';
+            std::cout << "Blank lines:    " << counts.blankLines << '\n';
+            std::cout << "Words:          " << counts.words << '\n';
+            std::cout << "Characters:     " << counts.chars << '\n';
             std::cout << '\n';
         }
-        if (pathNames.size() > 1)
+        if (pathCounts.size() > 1)
         {
-            std::cout << "Total lines:       " << lineCount << '\n';
-            std::cout << "Total blank lines: " << blankLineCount << '\n';
-            std::cout << "Total words:       " << wordCount << '\n';
-            std::cout << "Total characters:  " << charCount << '\n';
+            std::cout << "Total lines:       " << totals.lines << '\n';
+            std::cout << "Total blank lines: " << totals.blankLines << '\n';
+            std::cout << "Total words:       " << totals.words << '\n';
+            std::cout << "Total characters:  " << totals.chars << '\n';
         }
 
     }
 
 
 
+    // The num most frequent words (0: all of them), or the count of one word
     void printWords(std::int64_t num = 20, std::string word = "")
     {
         if (word == "")
         {
-            if (num > size(wordListWithCounts_Pairs) || num == 0)
-                num = size(wordListWithCounts_Pairs);
-            for (size_t n{}; n < num; ++n)
-                std::cout << wordListWithCounts_Pairs[n].first << "  -  " << wordListWithCounts_Pairs[n].second << '\n';
+            for (auto& [topWord, count] : words.top(static_cast<std::size_t>(std::max<std::int64_t>(num, 0))))
+                std::cout << topWord << "  -  " << count << '\n';
         }
         else
         {
-            if (wordListWithCounts.find("word") != wordListWithCounts.end())
-                std::cout << word << "  -  " << wordListWithCounts[word] << '\n';
+            if (std::int64_t count{words.find(word)})
+                std::cout << word << "  -  " << count << '\n';
             else
                 std::cout << "Could not find word: " << word << '\n';
         }
@@ -0,0 +1,299 @@
+#ifndef TEXTSCAN_H
+#define TEXTSCAN_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+#include <utility>
+#include <vector>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTSCAN_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+
+
+// A whole file mapped read-only into memory. Empty files give an empty view.
+class MappedFile
+{
+    const char* data{};
+    std::size_t length{};
+    bool opened{};
+#ifdef _WIN32
+    HANDLE file{INVALID_HANDLE_VALUE};
+    HANDLE mapping{};
+#endif
+
+public:
+    explicit MappedFile(const fs::path& path)
+        {
+#ifdef _WIN32
+            file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                               OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            LARGE_INTEGER size{};
+            if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size))
+                return;
+            opened = true;
+            length = static_cast<std::size_t>(size.QuadPart);
+            if (!length)
+                return;
+            mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping)
+                data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+            int fd{open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+            struct stat info{};
+            if (fd < 0)
+                return;
+            if (fstat(fd, &info) == 0)
+            {
+                opened = true;
+                length = static_cast<std::size_t>(info.st_size);
+                void* mapped{length ? mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED};
+                if (mapped != MAP_FAILED)
+                {
+                    data = static_cast<const char*>(mapped);
+                    madvise(mapped, length, MADV_SEQUENTIAL);
+                }
+            }
+            close(fd);
+#endif
+            if (length && !data)
+                opened = false;
+        }
+
+    ~MappedFile()
+        {
+#ifdef _WIN32
+            if (data)
+                UnmapViewOfFile(data);
+            if (mapping)
+                CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE)
+                CloseHandle(file);
+#else
+            if (data)
+                munmap(const_cast<char*>(data), length);
+#endif
+        }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const { return opened; }
+
+    std::string_view text() const { return data ? std::string_view{data, length} : std::string_view{}; }
+};
+
+
+
+// Line, blank line, word and character counts of a text. Blank lines are
+// empty (or only \r), words are split on whitespace and characters are the
+// letters and punctuation in words. A UTF-8 character counts once.
+struct TextCounts
+{
+    std::int64_t lines{};
+    std::int64_t blankLines{};
+    std::int64_t words{};
+    std::int64_t chars{};
+
+    TextCounts& operator+=(const TextCounts& other)
+    {
+        lines += other.lines;
+        blankLines += other.blankLines;
+        words += other.words;
+        chars += other.chars;
+        return *this;
+    }
+};
+
+namespace TextScan
+{
+    inline constexpr std::size_t blockSize{64};
+
+    // Byte classes
+    inline constexpr std::uint8_t space{1};         // isspace in the C locale
+    inline constexpr std::uint8_t newline{2};
+    inline constexpr std::uint8_t carriage{4};
+    inline constexpr std::uint8_t counted{8};       // Letter, punctuation or UTF-8 lead byte
+
+    inline constexpr std::array<std::uint8_t, 256> classes{[]
+    {
+        std::array<std::uint8_t, 256> table{};
+        for (std::size_t byte{}; byte < table.size(); ++byte)
+        {
+            if (byte == ' ' || (byte >= '\t' && byte <= '\r'))
+                table[byte] |= space;
+            if ((byte >= '!' && byte <= '~' && !(byte >= '0' && byte <= '9')) || byte >= 0xC0)
+                table[byte] |= counted;
+        }
+        table['\n'] |= newline;
+        table['\r'] |= carriage;
+        return table;
+    }()};
+
+    // One bit per byte of a 64-byte block, for each class
+    struct Masks
+    {
+        std::uint64_t space{};
+        std::uint64_t newline{};
+        std::uint64_t carriage{};
+        std::uint64_t counted{};
+    };
+
+    inline Masks classifyTable(const unsigned char* block)
+    {
+        Masks masks{};
+        for (std::size_t idx{}; idx < blockSize; ++idx)
+        {
+            std::uint64_t bit{std::uint64_t{1} << idx};
+            std::uint8_t byteClass{classes[block[idx]]};
+            masks.space |= (byteClass & space) ? bit : 0;
+            masks.newline |= (byteClass & newline) ? bit : 0;
+            masks.carriage |= (byteClass & carriage) ? bit : 0;
+            masks.counted |= (byteClass & counted) ? bit : 0;
+        }
+        return masks;
+    }
+
+#ifdef TEXTSCAN_SSE2
+    // Bytes in [low, low + span], as unsigned compares
+    inline __m128i inRange(__m128i bytes, std::uint8_t low, std::uint8_t span)
+    {
+        __m128i offset{_mm_sub_epi8(bytes, _mm_set1_epi8(static_cast<char>(low)))};
+        return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(static_cast<char>(span))), offset);
+    }
+
+    inline Masks classify(const unsigned char* block)
+    {
+        Masks masks{};
+        for (std::size_t part{}; part < blockSize / 16; ++part)
+        {
+            __m128i bytes{_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + part * 16))};
+            __m128i isSpace{_mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')), inRange(bytes, '\t', 4))};
+            __m128i isNewline{_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'))};
+            __m128i isCarriage{_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r'))};
+            __m128i isLead{_mm_cmpeq_epi8(_mm_max_epu8(bytes, _mm_set1_epi8(static_cast<char>(0xC0))), bytes)};
+            __m128i isCounted{_mm_or_si128(_mm_andnot_si128(inRange(bytes, '0', 9), inRange(bytes, '!', '~' - '!')),
+                                           isLead)};
+            int shift{static_cast<int>(part * 16)};
+            masks.space |= static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(isSpace))) << shift;
+            masks.newline |= static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(isNewline))) << shift;
+            masks.carriage |= static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(isCarriage))) << shift;
+            masks.counted |= static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(isCounted))) << shift;
+        }
+        return masks;
+    }
+#else
+    inline Masks classify(const unsigned char* block)
+    {
+        return classifyTable(block);
+    }
+#endif
+}
+
+
+
+// Count a text in one pass over 64-byte blocks, calling onWord with each
+// word. A text starting after a newline counts the same on its own, so
+// pieces split after newlines can be counted apart and added up.
+template <typename OnWord>
+TextCounts countText(std::string_view text, OnWord&& onWord)
+{
+    using namespace TextScan;
+    TextCounts counts{};
+    std::uint64_t prevSpace{1};       // Last bit of the previous block
+    std::uint64_t prevNewline{1};     // The text starts a line
+    std::uint64_t prevBlankCarriage{};
+    std::size_t wordStart{};
+
+    const unsigned char* bytes{reinterpret_cast<const unsigned char*>(text.data())};
+    unsigned char padded[blockSize]{};
+    for (std::size_t offset{}; offset < text.size(); offset += blockSize)
+    {
+        // The last block is padded with spaces, which count as nothing
+        const unsigned char* block{bytes + offset};
+        std::size_t remaining{text.size() - offset};
+        if (remaining < blockSize)
+        {
+            std::memset(padded, ' ', blockSize);
+            std::memcpy(padded, block, remaining);
+            block = padded;
+        }
+        Masks masks{classify(block)};
+
+        std::uint64_t lineStart{(masks.newline << 1) | prevNewline};
+        std::uint64_t blankCarriage{masks.carriage & lineStart};
+        std::uint64_t blank{masks.newline & (lineStart | (blankCarriage << 1) | prevBlankCarriage)};
+        std::uint64_t afterSpace{(masks.space << 1) | prevSpace};
+        std::uint64_t starts{~masks.space & afterSpace};
+        std::uint64_t ends{masks.space & ~afterSpace};
+
+        counts.lines += std::popcount(masks.newline);
+        counts.blankLines += std::popcount(blank);
+        counts.words += std::popcount(starts);
+        counts.chars += std::popcount(masks.counted);
+
+        // Word edges in order: a start, then the space ending it
+        for (std::uint64_t edges{starts | ends}; edges; edges &= edges - 1)
+        {
+            std::size_t pos{offset + static_cast<std::size_t>(std::countr_zero(edges))};
+            if (starts & edges & (~edges + 1))
+                wordStart = pos;
+            else
+                onWord(text.substr(wordStart, pos - wordStart));
+        }
+
+        prevSpace = masks.space >> 63;
+        prevNewline = masks.newline >> 63;
+        prevBlankCarriage = blankCarriage >> 63;
+    }
+
+    if (!prevSpace)
+        onWord(text.substr(wordStart));
+    if (!text.empty() && text.back() != '\n')
+        ++counts.lines;
+    return counts;
+}
+
+inline TextCounts countText(std::string_view text)
+{
+    return countText(text, [](std::string_view) {});
+}
+
+// Split a text into pieces of about chunkSize bytes, each ending just after
+// a newline (or at the end), for counting apart with countText
+inline std::vector<std::string_view> splitText(std::string_view text, std::size_t chunkSize)
+{
+    std::vector<std::string_view> pieces{};
+    while (text.size() > chunkSize)
+    {
+        std::size_t end{text.find('\n', chunkSize - 1)};
+        if (end == std::string_view::npos)
+            break;
+        pieces.push_back(text.substr(0, end + 1));
+        text.remove_prefix(end + 1);
+    }
+    if (!text.empty() || pieces.empty())
+        pieces.push_back(text);
+    return pieces;
+}
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef WORDTABLE_H
+#define WORDTABLE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+
+
+// Word frequencies in an open-addressing hash table (linear probing). Words
+// are copied once into an arena of large blocks, so a word costs its bytes
+// plus one slot, with no allocation per word.
+class WordTable
+{
+public:
+    using WordCount = std::pair<std::string_view, std::int64_t>;
+
+private:
+    static constexpr std::size_t blockSize{1 << 16};
+
+    struct Slot
+    {
+        std::string_view word{};
+        std::size_t hash{};
+        std::int64_t count{};       // 0: empty slot
+    };
+
+    std::vector<Slot> slots{};
+    std::size_t used{};
+    std::vector<std::unique_ptr<char[]>> blocks{};
+    std::size_t blockUsed{blockSize};
+
+    // Copy of word that lives as long as the table
+    std::string_view store(std::string_view word)
+    {
+        // Long words get a block of their own, leaving the last block filling
+        if (word.size() > blockSize / 4)
+        {
+            auto own{std::make_unique<char[]>(word.size())};
+            std::memcpy(own.get(), word.data(), word.size());
+            std::string_view copy{own.get(), word.size()};
+            blocks.insert(blocks.empty() ? blocks.end() : blocks.end() - 1, std::move(own));
+            return copy;
+        }
+        if (blockUsed + word.size() > blockSize)
+        {
+            blocks.push_back(std::make_unique<char[]>(blockSize));
+            blockUsed = 0;
+        }
+        char* copy{blocks.back().get() + blockUsed};
+        std::memcpy(copy, word.data(), word.size());
+        blockUsed += word.size();
+        return {copy, word.size()};
+    }
+
+    Slot& slotFor(std::string_view word, std::size_t hash)
+    {
+        std::size_t mask{slots.size() - 1};
+        for (std::size_t idx{hash & mask}; ; idx = (idx + 1) & mask)
+        {
+            Slot& slot{slots[idx]};
+            if (!slot.count || (slot.hash == hash && slot.word == word))
+                return slot;
+        }
+    }
+
+    // Double the slots once they are 70% full
+    void grow()
+    {
+        std::vector<Slot> old(std::max<std::size_t>(slots.size() * 2, 1024));
+        old.swap(slots);
+        for (auto& slot : old)
+            if (slot.count)
+                slotFor(slot.word, slot.hash) = slot;
+    }
+
+public:
+    std::size_t size() const { return used; }
+
+    void add(std::string_view word, std::int64_t count = 1)
+    {
+        if ((used + 1) * 10 > slots.size() * 7)
+            grow();
+        std::size_t hash{std::hash<std::string_view>{}(word)};
+        Slot& slot{slotFor(word, hash)};
+        if (!slot.count)
+        {
+            slot.word = store(word);
+            slot.hash = hash;
+            ++used;
+        }
+        slot.count += count;
+    }
+
+    // Count of word, 0 if it was never added
+    std::int64_t find(std::string_view word) const
+    {
+        if (!used)
+            return 0;
+        std::size_t hash{std::hash<std::string_view>{}(word)};
+        std::size_t mask{slots.size() - 1};
+        for (std::size_t idx{hash & mask}; slots[idx].count; idx = (idx + 1) & mask)
+            if (slots[idx].hash == hash && slots[idx].word == word)
+                return slots[idx].count;
+        return 0;
+    }
+
+    void merge(const WordTable& other)
+    {
+        for (auto& slot : other.slots)
+            if (slot.count)
+                add(slot.word, slot.count);
+    }
+
+    // The num most frequent words, most frequent first (ties in word order),
+    // picked with a bounded min-heap instead of sorting every word. 0: all.
+    std::vector<WordCount> top(std::size_t num) const
+    {
+        if (!num || num > used)
+            num = used;
+        auto before = [](const WordCount& a, const WordCount& b)
+            {return a.second > b.second || (a.second == b.second && a.first < b.first);};
+
+        std::vector<WordCount> heap{};
+        heap.reserve(num);
+        for (auto& slot : slots)
+        {
+            if (!slot.count || !num)
+                continue;
+            WordCount entry{slot.word, slot.count};
+            if (heap.size() < num)
+            {
+                heap.push_back(entry);
+                std::push_heap(heap.begin(), heap.end(), before);
+            }
+            else if (before(entry, heap.front()))
+            {
+                std::pop_heap(heap.begin(), heap.end(), before);
+                heap.back() = entry;
+                std::push_heap(heap.begin(), heap.end(), before);
+            }
+        }
+        std::sort_heap(heap.begin(), heap.end(), before);
+        return heap;
+    }
+};
+
+#endif